@@ -0,0 +1,48 @@
+#include "BatchLexer.h"
+#include "TokenStream.h"
+
+#include <map>
+
+BatchLexer::BatchLexer(std::shared_ptr<const LexerSpec> spec, const LexerOptions& options, std::size_t numThreads) :
+	m_pool(numThreads)
+{
+	for (std::size_t i = 0; i < m_pool.GetNumThreads(); ++i)
+	{
+		m_lexers.emplace_back(new Lexer(spec, options));
+	}
+}
+
+void BatchLexer::LexMany(const std::vector<std::string>& fileNames, const Callback& callback, Delivery delivery)
+{
+	std::mutex deliveryMutex;
+	std::map<std::size_t, std::pair<bool, std::vector<std::uint8_t>>> pending;
+	std::size_t nextIndex = 0;
+
+	m_pool.Run(fileNames.size(), [&](std::size_t worker, std::size_t index)
+	{
+		Lexer& lexer = *m_lexers[worker];
+		const bool isRead = lexer.Reset(fileNames[index].c_str());
+
+		PackedTokenWriter writer;
+		writer.Append(lexer);
+		std::vector<std::uint8_t> stream = writer.Finish();
+
+		std::lock_guard<std::mutex> lock(deliveryMutex);
+
+		if (delivery == Delivery::AS_COMPLETED)
+		{
+			callback(index, isRead, stream);
+			return;
+		}
+
+		// Results that finish early wait until every earlier input has been delivered
+		pending.emplace(index, std::make_pair(isRead, std::move(stream)));
+
+		while (!pending.empty() && pending.begin()->first == nextIndex)
+		{
+			callback(nextIndex, pending.begin()->second.first, pending.begin()->second.second);
+			pending.erase(pending.begin());
+			++nextIndex;
+		}
+	});
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef BATCH_LEXER_H
+#define BATCH_LEXER_H
+
+#include "Lexer.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+
+// Lexes many files on a work-stealing pool into packed token streams (see TokenStream.h).
+// Each worker keeps one Lexer that is reset between files instead of rebuilt.
+class BatchLexer
+{
+public:
+	enum class Delivery
+	{
+		IN_ORDER,
+		AS_COMPLETED
+	};
+
+	// Calls are serialized, but may come from any worker thread.
+	// An unreadable file has isRead false and the stream of an empty source.
+	using Callback = std::function<void(std::size_t index, bool isRead, std::vector<std::uint8_t>& stream)>;
+
+	explicit BatchLexer(std::shared_ptr<const LexerSpec> spec = LexerSpec::GetDefault(),
+		const LexerOptions& options = LexerOptions(), std::size_t numThreads = 0);
+
+	void LexMany(const std::vector<std::string>& fileNames, const Callback& callback,
+		Delivery delivery = Delivery::IN_ORDER);
+
+private:
+	WorkStealingPool m_pool;
+	std::vector<std::unique_ptr<Lexer>> m_lexers;
+};
+
+#endif
\ No newline at end of file
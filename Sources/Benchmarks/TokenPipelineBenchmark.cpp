@@ -0,0 +1,90 @@
+// Compares lexing inline with lexing through a TokenPipeline, for a consumer
+// that spends a given number of loop iterations on every token. Not part of
+// the project, build it as a console program together with the sources in
+// the parent directory, with optimizations on:
+//
+//	TokenPipelineBenchmark <file> <iterations per token>
+
+#include "TokenPipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	volatile unsigned g_sink;
+
+	// Stands in for the parser's per-token cost
+	void ConsumeToken(int iterations)
+	{
+		unsigned hash = 0;
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			hash = hash * 31 + i;
+		}
+
+		g_sink = hash;
+	}
+
+	template<typename Source>
+	void Run(const char* name, Source& source, int iterations)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		std::size_t tokenCount = 0;
+
+		while (true)
+		{
+			Token* token = source.GetToken();
+			const TokenType type = token->token;
+			delete token;
+
+			// The pipeline drops comments, so the inline run must too
+			if (type == TokenType::UNKNOWN)
+			{
+				continue;
+			}
+
+			++tokenCount;
+			ConsumeToken(iterations);
+
+			if (type == TokenType::END_OF_FILE)
+			{
+				break;
+			}
+		}
+
+		const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::printf("%-8s %zu tokens, %.1f ms\n", name, tokenCount, elapsed);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "Usage: %s <file> <iterations per token>\n", argv[0]);
+		return 1;
+	}
+
+	const int iterations = std::atoi(argv[2]);
+
+	Lexer lexer(LexerSpec::GetDefault());
+
+	if (!lexer.Reset(argv[1]))
+	{
+		std::fprintf(stderr, "Cannot read %s\n", argv[1]);
+		return 1;
+	}
+
+	Run("inline", lexer, iterations);
+
+	lexer.Reset(argv[1]);
+
+	TokenPipeline pipeline(lexer);
+	Run("pipeline", pipeline, iterations);
+
+	return 0;
+}
\ No newline at end of file
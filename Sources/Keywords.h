@@ -0,0 +1,153 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <cstddef>
+#include <stdexcept>
+
+enum class TokenType;
+
+struct KeywordEntry
+{
+	const char* text;
+	std::size_t length;
+	TokenType token;
+};
+
+constexpr std::size_t RoundUpToPowerOfTwo(std::size_t value)
+{
+	std::size_t result = 1;
+
+	while (result < value)
+	{
+		result <<= 1;
+	}
+
+	return result;
+}
+
+// Non-owning view of a KeywordTable of any size, which is how a LexerSpec holds its keywords.
+// The table must outlive the view, normally by being a constexpr object with static storage.
+class KeywordView
+{
+public:
+	constexpr KeywordView(const KeywordEntry* slots, std::size_t numSlots) :
+		m_slots(slots), m_numSlots(numSlots)
+	{
+
+	}
+
+	// Returns nullptr when the string is not a keyword
+	constexpr const KeywordEntry* Match(const char* str, std::size_t length, bool isCaseInsensitive) const
+	{
+		for (std::size_t slot = Hash(str, length, isCaseInsensitive) & (m_numSlots - 1);
+			m_slots[slot].text != nullptr; slot = (slot + 1) & (m_numSlots - 1))
+		{
+			if (m_slots[slot].length == length && IsEqual(m_slots[slot].text, str, length, isCaseInsensitive))
+			{
+				return &m_slots[slot];
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Slots are in hash order and unused ones have a null text
+	const KeywordEntry* GetSlots() const
+	{
+		return m_slots;
+	}
+
+	std::size_t GetNumSlots() const
+	{
+		return m_numSlots;
+	}
+
+	static constexpr std::size_t Hash(const char* str, std::size_t length, bool isCaseInsensitive)
+	{
+		return length * 7 + static_cast<unsigned char>(Fold(str[0], isCaseInsensitive)) * 3 +
+			static_cast<unsigned char>(Fold(str[length - 1], isCaseInsensitive));
+	}
+
+private:
+	static constexpr char Fold(char ch, bool isCaseInsensitive)
+	{
+		return isCaseInsensitive && ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+	}
+
+	static constexpr bool IsEqual(const char* keyword, const char* str, std::size_t length, bool isCaseInsensitive)
+	{
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			if (keyword[i] != Fold(str[i], isCaseInsensitive))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	const KeywordEntry* m_slots;
+	std::size_t m_numSlots;
+};
+
+// Open-addressing keyword table that is filled in by the compiler, so it sits in
+// read-only data and costs nothing at startup. Keywords must be written in lowercase,
+// since case-insensitive matching only folds the input.
+template <std::size_t N>
+class KeywordTable
+{
+public:
+	// At most half full, so probes stay short
+	static constexpr std::size_t NUM_SLOTS = RoundUpToPowerOfTwo(N * 2);
+
+	constexpr explicit KeywordTable(const KeywordEntry (&entries)[N]) : m_slots{}
+	{
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			// Stops the compiler when the table is built as a constant
+			if (HasUppercase(entries[i].text, entries[i].length))
+			{
+				throw std::invalid_argument("Keywords must be lowercase");
+			}
+
+			std::size_t slot = KeywordView::Hash(entries[i].text, entries[i].length, false) & (NUM_SLOTS - 1);
+
+			while (m_slots[slot].text != nullptr)
+			{
+				slot = (slot + 1) & (NUM_SLOTS - 1);
+			}
+
+			m_slots[slot] = entries[i];
+		}
+	}
+
+	constexpr KeywordView GetView() const
+	{
+		return KeywordView(m_slots, NUM_SLOTS);
+	}
+
+private:
+	static constexpr bool HasUppercase(const char* str, std::size_t length)
+	{
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			if (str[i] >= 'A' && str[i] <= 'Z')
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	KeywordEntry m_slots[NUM_SLOTS];
+};
+
+template <std::size_t N>
+constexpr KeywordTable<N> MakeKeywordTable(const KeywordEntry (&entries)[N])
+{
+	return KeywordTable<N>(entries);
+}
+
+#endif
\ No newline at end of file
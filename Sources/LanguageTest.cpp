@@ -0,0 +1,87 @@
+#include "LanguageTest.h"
+
+LanguageTestRunner::LanguageTestRunner(std::shared_ptr<const LexerSpec> spec, const LexerOptions& options, std::size_t numThreads) :
+	m_pool(numThreads), m_timeBudget(0)
+{
+	for (std::size_t i = 0; i < m_pool.GetNumThreads(); ++i)
+	{
+		m_lexers.emplace_back(new Lexer(spec, options));
+	}
+}
+
+std::vector<LanguageTestResult> LanguageTestRunner::Run(const std::vector<LanguageTest>& tests)
+{
+	std::vector<LanguageTestResult> results(tests.size());
+
+	m_pool.Run(tests.size(), [&](std::size_t worker, std::size_t index)
+	{
+		results[index] = RunOne(*m_lexers[worker], tests[index]);
+	});
+
+	return results;
+}
+
+LanguageTestResult LanguageTestRunner::RunOne(Lexer& lexer, const LanguageTest& test) const
+{
+	LanguageTestResult result;
+	std::vector<TokenType> tokens;
+	bool hasError = false;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	lexer.Reset(test.source.c_str(), test.source.size());
+
+	while (true)
+	{
+		Token* token = lexer.GetToken();
+		const TokenType type = token->token;
+		delete token;
+
+		if (type == TokenType::END_OF_FILE)
+		{
+			break;
+		}
+
+		if (type == TokenType::UNKNOWN)
+		{
+			continue;
+		}
+
+		hasError |= type == TokenType::ERROR;
+		tokens.push_back(type);
+	}
+
+	result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	result.isPassed = false;
+
+	if (hasError == test.isAccepted)
+	{
+		result.message = test.isAccepted ? "expected to be accepted" : "expected to be rejected";
+		return result;
+	}
+
+	if (!test.expectedTokens.empty() && tokens != test.expectedTokens)
+	{
+		std::size_t i = 0;
+		while (i < tokens.size() && i < test.expectedTokens.size() && tokens[i] == test.expectedTokens[i])
+		{
+			++i;
+		}
+
+		result.message = "token stream differs at token " + std::to_string(i) +
+			" (expected " + std::to_string(test.expectedTokens.size()) +
+			" tokens, got " + std::to_string(tokens.size()) + ")";
+		return result;
+	}
+
+	if (m_timeBudget.count() > 0 && result.elapsed > m_timeBudget)
+	{
+		result.message = "took " + std::to_string(result.elapsed.count()) + "us, budget is " +
+			std::to_string(m_timeBudget.count()) + "us";
+		return result;
+	}
+
+	result.isPassed = true;
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef LANGUAGE_TEST_H
+#define LANGUAGE_TEST_H
+
+#include "Lexer.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+
+struct LanguageTest
+{
+	std::string name;
+	std::string source;
+
+	// Accepted snippets lex without ERROR tokens, rejected ones produce at least one
+	bool isAccepted;
+
+	// Checked only when not empty; comments and END_OF_FILE are not listed
+	std::vector<TokenType> expectedTokens;
+};
+
+struct LanguageTestResult
+{
+	bool isPassed;
+	std::chrono::microseconds elapsed;
+
+	// Human-readable reason, empty when passed
+	std::string message;
+};
+
+// Runs snippets in parallel on one lexer per worker, all sharing the same spec
+class LanguageTestRunner
+{
+public:
+	explicit LanguageTestRunner(std::shared_ptr<const LexerSpec> spec = LexerSpec::GetDefault(),
+		const LexerOptions& options = LexerOptions(), std::size_t numThreads = 0);
+
+	// Snippets that take longer than the budget fail, zero means no budget
+	void SetTimeBudget(std::chrono::microseconds budget)
+	{
+		m_timeBudget = budget;
+	}
+
+	std::vector<LanguageTestResult> Run(const std::vector<LanguageTest>& tests);
+
+private:
+	LanguageTestResult RunOne(Lexer& lexer, const LanguageTest& test) const;
+
+	WorkStealingPool m_pool;
+	std::vector<std::unique_ptr<Lexer>> m_lexers;
+	std::chrono::microseconds m_timeBudget;
+};
+
+#endif
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "Lexer.h"
+#include "Utf8.h"
 
-#include <array>
+#include <cstring>
 
-std::array<Symbol, 256> CHAR_TO_SYMBOL_MAP =
+const std::array<Symbol, 256> CHAR_TO_SYMBOL_MAP =
 {
 	/* 000 nul */	Symbol::UNDEFINED,
 	/* 001 soh */	Symbol::UNDEFINED,
@@ -17,7 +18,7 @@ std::array<Symbol, 256> CHAR_TO_SYMBOL_MAP =
 	/* 012 nl  */	Symbol::NEWLINE,
 	/* 013 vt  */	Symbol::BLANK,
 	/* 014 ff  */	Symbol::BLANK,
-	/* 015 cr  */	Symbol::UNDEFINED,
+	/* 015 cr  */	Symbol::BLANK,
 	/* 016 so  */	Symbol::UNDEFINED,
 	/* 017 si  */	Symbol::UNDEFINED,
 	/* 020 dle */	Symbol::UNDEFINED,
@@ -133,9 +134,6 @@ std::array<Symbol, 256> CHAR_TO_SYMBOL_MAP =
 	/* 176 ~   */	Symbol::UNDEFINED
 };
 
-int Lexer::m_lineBufferSize = 2049;
-unsigned int Lexer::m_tokenMaxLength = 32;
-
 #define COMPLEX_OPERATOR_DFA(ch1stSymbol, ch2ndSymbol, singleOperator, complexOperator)	\
 {\
 	if (*m_tokenIter == ch1stSymbol)	\
@@ -148,7 +146,7 @@ unsigned int Lexer::m_tokenMaxLength = 32;
 		}	\
 		else\
 		{	\
-			if (CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_tokenHead)] == Symbol::INDICATOR)	\
+			if (m_symbolMap[static_cast<unsigned char>(*m_tokenHead)] == Symbol::INDICATOR)	\
 			{	\
 				token->token = TokenType::ERROR;	\
 				/* TODO: Report the error */	\
@@ -162,34 +160,33 @@ unsigned int Lexer::m_tokenMaxLength = 32;
 	}\
 }
 
-int Lexer::IdentifierDFA::m_idMaxLength = 32;
-const char* Lexer::IdentifierDFA::m_keywords[] =
+void Lexer::IdentifierDFA::GetToken(Token* token) const
 {
-	"if",
-	"else",
-	"for",
-	"while",
-	"return",
-	"continue",
-	"break",
-	"char",
-	"goto",
-	"int",
-	"double",
-	"void",
-	"read",
-	"write",
-	nullptr
-};
+	// The first character is either an ASCII letter or a non-ASCII XID_Start character
+	const char* next = MatchXidStart(m_lexer.m_tokenIter, m_lexer.m_sourceEnd);
+	m_lexer.m_tokenIter += next != nullptr ? next - m_lexer.m_tokenIter : 1;
 
-void Lexer::IdentifierDFA::GetToken(Token* token)
-{
-	while (+(CHAR_TO_SYMBOL_MAP[static_cast<int>(*++m_lexer.m_tokenIter)] & (Symbol::DIGIT | Symbol::LETTER)))
+	while (true)
 	{
-		// Do nothing	
+		while (+(m_lexer.m_symbolMap[static_cast<unsigned char>(*m_lexer.m_tokenIter)] & (Symbol::DIGIT | Symbol::LETTER)))
+		{
+			++m_lexer.m_tokenIter;
+		}
+
+		// Bytes >= 0x80 are undefined in the table and fall through to the XID tables
+		next = MatchXidContinue(m_lexer.m_tokenIter, m_lexer.m_sourceEnd);
+		if (next == nullptr)
+		{
+			break;
+		}
+
+		m_lexer.m_tokenIter += next - m_lexer.m_tokenIter;
 	}
 
-	if ((m_lexer.m_tokenIter - m_lexer.m_tokenHead) / sizeof(char) > m_tokenMaxLength)
+	const std::size_t charCount = m_lexer.m_tokenIter - m_lexer.m_tokenHead;
+
+	if (m_lexer.ExceedsLimit(charCount, m_lexer.m_options.maxIdentifierLength) ||
+		m_lexer.ExceedsLimit(charCount, m_lexer.m_options.maxTokenLength))
 	{
 		token->token = TokenType::ERROR;
 
@@ -199,97 +196,24 @@ void Lexer::IdentifierDFA::GetToken(Token* token)
 	{
 		assert(m_lexer.m_tokenIter > m_lexer.m_tokenHead);
 
-		const char temp = *m_lexer.m_tokenIter;
-		*m_lexer.m_tokenIter = '\0';
-
-		const char * keyword = GetKeyword(m_lexer.m_tokenHead);
-
-		*m_lexer.m_tokenIter = temp;
+		token->token = m_lexer.IsKeywordPossible() ?
+			m_lexer.m_spec->GetKeyword(m_lexer.m_tokenHead, m_lexer.m_tokenIter - m_lexer.m_tokenHead) : TokenType::ID;
 
-		if (keyword != nullptr)
-		{
-			switch (*keyword)
-			{
-			case 'b':
-				token->token = TokenType::KEYWORD_BREAK;
-				break;
-			case 'c':
-				if (*++keyword == 'h')
-				{
-					token->token = TokenType::KEYWORD_CHAR;
-				}
-				else
-				{
-					token->token = TokenType::KEYWORD_CONTINUE;
-				}
-				break;
-			case 'd':
-				token->token = TokenType::KEYWORD_DOUBLE;
-				break;
-			case 'e':
-				token->token = TokenType::KEYWORD_ELSE;
-				break;
-			case 'f':
-				token->token = TokenType::KEYWORD_FOR;
-				break;
-			case 'g':
-				token->token = TokenType::KEYWORD_GOTO;
-				break;
-			case 'i':
-				if (*++keyword == 'f')
-				{
-					token->token = TokenType::KEYWORD_IF;
-				}
-				else
-				{
-					token->token = TokenType::KEYWORD_INT;
-				}
-				break;
-			case 'r':
-				if (keyword[2] == 'a')
-				{
-					token->token = TokenType::KEYWORD_READ;
-				}
-				else
-				{
-					token->token = TokenType::KEYWORD_RETURN;
-				}
-				break;
-			case 'v':
-				token->token = TokenType::KEYWORD_VOID;
-				break;
-			case 'w':
-				if (*++keyword == 'h')
-				{
-					token->token = TokenType::KEYWORD_WHILE;
-				}
-				else
-				{
-					token->token = TokenType::KEYWORD_WRITE;
-				}
-				break;
-			default:
-				assert(nullptr);
-				token->token = TokenType::ERROR;
-				// TODO: Report the error
-			}
-		}
-		else
+		// A weak keyword is an identifier wherever the parser can't shift it
+		if (token->token == TokenType::ID || (!m_lexer.IsAcceptable(token->token) &&
+			m_lexer.m_spec->GetWeakKeywords().test(static_cast<std::size_t>(token->token))))
 		{
 			token->token = TokenType::ID;
 			token->val.strVal = new char[m_lexer.m_tokenIter - m_lexer.m_tokenHead + 1];
 			memset(token->val.strVal, 0, m_lexer.m_tokenIter - m_lexer.m_tokenHead + 1);
-			strncpy_s(token->val.strVal, m_lexer.m_tokenIter - m_lexer.m_tokenHead, m_lexer.m_tokenHead, m_lexer.m_tokenIter - m_lexer.m_tokenHead);
+			strncpy_s(token->val.strVal, m_lexer.m_tokenIter - m_lexer.m_tokenHead + 1, m_lexer.m_tokenHead, m_lexer.m_tokenIter - m_lexer.m_tokenHead);
 		}
 	}
 }
 
-int Lexer::NumericsDFA::m_wordLength = 16;
-unsigned int Lexer::NumericsDFA::m_bufferMaxSize = 32;
-
 void Lexer::NumericsDFA::GetToken(Token* token) const
 {
-	while (+(CHAR_TO_SYMBOL_MAP[static_cast<int>(*++m_lexer.m_tokenIter)] & Symbol::DIGIT))
+	while (+(m_lexer.m_symbolMap[static_cast<unsigned char>(*++m_lexer.m_tokenIter)] & Symbol::DIGIT))
 	{
 		// Do nothing	
 	}
@@ -300,7 +224,7 @@ void Lexer::NumericsDFA::GetToken(Token* token) const
 	}
 	else
 	{
-		if (CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_lexer.m_tokenIter)] == Symbol::LETTER)
+		if (m_lexer.m_symbolMap[static_cast<unsigned char>(*m_lexer.m_tokenIter)] == Symbol::LETTER)
 		{
 			token->token = TokenType::ERROR;
 
@@ -316,7 +240,7 @@ void Lexer::NumericsDFA::GetToken(Token* token) const
 
 	if (*m_lexer.m_tokenIter == '.')
 	{
-		while (CHAR_TO_SYMBOL_MAP[static_cast<int>(*++m_lexer.m_tokenIter)] == Symbol::DIGIT)
+		while (m_lexer.m_symbolMap[static_cast<unsigned char>(*++m_lexer.m_tokenIter)] == Symbol::DIGIT)
 		{
 			// Do nothing
 		}
@@ -329,14 +253,14 @@ void Lexer::NumericsDFA::GetToken(Token* token) const
 				++m_lexer.m_tokenIter;
 			}
 
-			if (+(CHAR_TO_SYMBOL_MAP[static_cast<int>(*++m_lexer.m_tokenIter)] & Symbol::DIGIT))
+			if (+(m_lexer.m_symbolMap[static_cast<unsigned char>(*++m_lexer.m_tokenIter)] & Symbol::DIGIT))
 			{
-				while (+(CHAR_TO_SYMBOL_MAP[static_cast<int>(*++m_lexer.m_tokenIter)] & Symbol::DIGIT))
+				while (+(m_lexer.m_symbolMap[static_cast<unsigned char>(*++m_lexer.m_tokenIter)] & Symbol::DIGIT))
 				{
 					// Do nothing
 				}
 
-				if (+(CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_lexer.m_tokenIter)] & Symbol::LETTER))
+				if (+(m_lexer.m_symbolMap[static_cast<unsigned char>(*m_lexer.m_tokenIter)] & Symbol::LETTER))
 				{
 					token->token = TokenType::ERROR;
 
@@ -356,7 +280,7 @@ void Lexer::NumericsDFA::GetToken(Token* token) const
 		}
 		else
 		{
-			if (+(CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_lexer.m_tokenIter)] & Symbol::LETTER))
+			if (+(m_lexer.m_symbolMap[static_cast<unsigned char>(*m_lexer.m_tokenIter)] & Symbol::LETTER))
 			{
 				token->token = TokenType::ERROR;
 
@@ -376,9 +300,10 @@ void Lexer::NumericsDFA::GetToken(Token* token) const
 EXIT_FUNC:
 	if (token->token == TokenType::NUM_INT || token->token == TokenType::NUM_DOUBLE)
 	{
-		const unsigned int charCount = m_lexer.m_tokenIter - m_lexer.m_tokenHead;
+		const std::size_t charCount = m_lexer.m_tokenIter - m_lexer.m_tokenHead;
 
-		if (charCount > m_bufferMaxSize)
+		if (m_lexer.ExceedsLimit(charCount, m_lexer.m_options.maxNumericLength) ||
+			m_lexer.ExceedsLimit(charCount, m_lexer.m_options.maxTokenLength))
 		{
 			token->token = TokenType::ERROR;
 
@@ -388,21 +313,18 @@ EXIT_FUNC:
 		{
 			token->val.strVal = new char[charCount + 1];
 			memset(token->val.strVal, 0, charCount + 1);
-			strncpy_s(token->val.strVal, charCount, m_lexer.m_tokenHead, charCount);
+			strncpy_s(token->val.strVal, charCount + 1, m_lexer.m_tokenHead, charCount);
 		}
 	}
 }
 
-int Lexer::CharDFA::m_charSeqMaxLength = 4;
-char Lexer::CharDFA::m_reservedEscSeq[10] = { '\0' };
-
 void Lexer::CharDFA::GetToken(Token* token) const
 {
 	int charCount;
 
 	++m_lexer.m_tokenIter;
 
-	while (*m_lexer.m_tokenIter != '\'' && *m_lexer.m_tokenIter != '\0')
+	while (*m_lexer.m_tokenIter != '\'' && *m_lexer.m_tokenIter != '\n' && *m_lexer.m_tokenIter != '\0')
 	{
 		++m_lexer.m_tokenIter;
 	}
@@ -489,15 +411,13 @@ EXIT_FUNC:
 	}
 }
 
-int Lexer::StringDFA::m_strMaxLength = 32;
-
 void Lexer::StringDFA::GetToken(Token* token) const
 {
 	int charCount;
 
 	++m_lexer.m_tokenIter;
 
-	while (*m_lexer.m_tokenIter != '"' && *m_lexer.m_tokenIter != '\0')
+	while (*m_lexer.m_tokenIter != '"' && *m_lexer.m_tokenIter != '\n' && *m_lexer.m_tokenIter != '\0')
 	{
 		++m_lexer.m_tokenIter;
 	}
@@ -513,7 +433,8 @@ void Lexer::StringDFA::GetToken(Token* token) const
 		charCount = (m_lexer.m_tokenIter - m_lexer.m_tokenHead - 1) / sizeof(char);
 		assert(charCount >= 0);
 
-		if (charCount > m_strMaxLength)
+		if (m_lexer.ExceedsLimit(charCount, m_lexer.m_options.maxStringLength) ||
+			m_lexer.ExceedsLimit(charCount + 2, m_lexer.m_options.maxTokenLength))
 		{
 			token->token = TokenType::ERROR;
 
@@ -524,19 +445,20 @@ void Lexer::StringDFA::GetToken(Token* token) const
 			token->token = TokenType::STRING_LITERAL;
 			token->val.strVal = new char[charCount + 1];
 			memset(token->val.strVal, 0, charCount + 1);
-			strncpy_s(token->val.strVal, charCount, m_lexer.m_tokenHead + 1, charCount);
+			strncpy_s(token->val.strVal, charCount + 1, m_lexer.m_tokenHead + 1, charCount);
 		}
+
+		++m_lexer.m_tokenIter;
 	}
 }
 
 void Lexer::CommentDFA::GetToken(Token* token) const
 {
 	bool isExitComment = false;
-	bool isReadNewLine = false;
 
 	if (*m_lexer.m_tokenIter == '/')
 	{
-		while (*++m_lexer.m_tokenIter != '\0')
+		while (*++m_lexer.m_tokenIter != '\n' && *m_lexer.m_tokenIter != '\0')
 		{
 			// Do nothing;
 		}
@@ -547,38 +469,19 @@ void Lexer::CommentDFA::GetToken(Token* token) const
 	{
 		while (true)
 		{
-			if (!isReadNewLine)
-			{
-				++m_lexer.m_tokenIter;
-			}
-			else
-			{
-				isReadNewLine = false;
-			}
+			++m_lexer.m_tokenIter;
 
 			if (*m_lexer.m_tokenIter == '*')
 			{
 				isExitComment = true;
 			}
-			else if (*m_lexer.m_tokenIter == '\0')
+			else if (*m_lexer.m_tokenIter == '\0' && m_lexer.m_tokenIter == m_lexer.m_sourceEnd)
 			{
-				memset(m_lexer.m_lineBuffer, 0, m_lineBufferSize);
-				if (m_lexer.m_sourceFile.get(m_lexer.m_lineBuffer, m_lineBufferSize))
-				{
-					m_lexer.m_tokenIter = m_lexer.m_lineBuffer;
-					++m_lexer.m_lineNumber;
-				}
-				else
-				{
-					token->token = TokenType::ERROR;
-
-					// TODO: Report the error
+				token->token = TokenType::ERROR;
 
-					break;
-				}
+				// TODO: Report the error
 
-				isReadNewLine = true;
-				isExitComment = false;
+				break;
 			}
 			else if (*m_lexer.m_tokenIter == '/')
 			{
@@ -601,26 +504,216 @@ void Lexer::CommentDFA::GetToken(Token* token) const
 	}
 }
 
-Lexer::Lexer(const char* fileName) :
+namespace
+{
+	constexpr KeywordEntry MINUSC_KEYWORDS[] =
+	{
+		{ "if",			2, TokenType::KEYWORD_IF },
+		{ "else",		4, TokenType::KEYWORD_ELSE },
+		{ "for",		3, TokenType::KEYWORD_FOR },
+		{ "while",		5, TokenType::KEYWORD_WHILE },
+		{ "return",		6, TokenType::KEYWORD_RETURN },
+		{ "continue",	8, TokenType::KEYWORD_CONTINUE },
+		{ "break",		5, TokenType::KEYWORD_BREAK },
+		{ "char",		4, TokenType::KEYWORD_CHAR },
+		{ "goto",		4, TokenType::KEYWORD_GOTO },
+		{ "int",		3, TokenType::KEYWORD_INT },
+		{ "double",		6, TokenType::KEYWORD_DOUBLE },
+		{ "void",		4, TokenType::KEYWORD_VOID },
+		{ "read",		4, TokenType::KEYWORD_READ },
+		{ "write",		5, TokenType::KEYWORD_WRITE }
+	};
+
+	constexpr auto MINUSC_KEYWORD_TABLE = MakeKeywordTable(MINUSC_KEYWORDS);
+	constexpr KeywordView MINUSC_KEYWORD_VIEW = MINUSC_KEYWORD_TABLE.GetView();
+
+	static_assert(MINUSC_KEYWORD_VIEW.Match("continue", 8, false)->token == TokenType::KEYWORD_CONTINUE, "Keyword table is broken");
+	static_assert(MINUSC_KEYWORD_VIEW.Match("While", 5, true)->token == TokenType::KEYWORD_WHILE, "Keyword table is broken");
+	static_assert(MINUSC_KEYWORD_VIEW.Match("While", 5, false) == nullptr, "Keyword table is broken");
+	static_assert(MINUSC_KEYWORD_VIEW.Match("integer", 7, false) == nullptr, "Keyword table is broken");
+}
+
+TokenType LexerSpec::GetKeyword(const char* str, std::size_t length) const
+{
+	const KeywordEntry* keyword = m_keywords.Match(str, length, m_isCaseInsensitive);
+
+	return keyword != nullptr ? keyword->token : TokenType::ID;
+}
+
+LexerSpec::LexerSpec(bool isCaseInsensitive) :
+	LexerSpec(MINUSC_KEYWORD_VIEW, isCaseInsensitive)
+{
+
+}
+
+LexerSpec::LexerSpec(bool isCaseInsensitive, const TerminalSet& weakKeywords) :
+	LexerSpec(MINUSC_KEYWORD_VIEW, isCaseInsensitive, weakKeywords)
+{
+
+}
+
+LexerSpec::LexerSpec(const KeywordView& keywords, bool isCaseInsensitive, const TerminalSet& weakKeywords) :
+	m_symbolMap(CHAR_TO_SYMBOL_MAP), m_keywords(keywords), m_isCaseInsensitive(isCaseInsensitive)
+{
+	for (std::size_t i = 0; i < m_keywords.GetNumSlots(); ++i)
+	{
+		if (m_keywords.GetSlots()[i].text != nullptr)
+		{
+			m_keywordSet.set(static_cast<std::size_t>(m_keywords.GetSlots()[i].token));
+		}
+	}
+
+	m_weakKeywords = weakKeywords & m_keywordSet;
+	m_strongKeywords = m_keywordSet & ~m_weakKeywords;
+}
+
+std::shared_ptr<const LexerSpec> LexerSpec::GetDefault()
+{
+	static const std::shared_ptr<const LexerSpec> spec = std::make_shared<const LexerSpec>();
+
+	return spec;
+}
+
+Lexer::Lexer(const char* fileName, const LexerOptions& options) :
+	Lexer(LexerSpec::GetDefault(), options)
+{
+	const bool isRead = Reset(fileName);
+	assert(isRead);
+	(void)isRead;
+}
+
+Lexer::Lexer(std::shared_ptr<const LexerSpec> spec, const LexerOptions& options) :
 	m_identifierDFA(*this), m_numericsDFA(*this),
 	m_charDFA(*this), m_stringDFA(*this), m_commentDFA(*this),
-	m_lineBufferTail(nullptr)
+	m_spec(std::move(spec)), m_symbolMap(m_spec->GetSymbolMap()), m_options(options),
+	m_acceptable(nullptr)
 {
-	m_sourceFile.open(fileName);
-	assert(m_sourceFile.is_open());
+	ResetSource(false);
+}
 
-	m_lineBuffer = new char[m_lineBufferSize];
-	memset(m_lineBuffer, 0, m_lineBufferSize);
+Lexer::~Lexer()
+{
 
-	m_sourceFile.get(m_lineBuffer, m_lineBufferSize);
-	m_tokenHead = m_tokenIter = m_lineBuffer;
+}
+
+bool Lexer::Reset(const char* fileName)
+{
+	const ReadStatus status = ReadFile(fileName, m_source, m_options.maxMemoryBytes);
 
-	m_lineNumber = 1;
+	ResetSource(status == ReadStatus::TOO_LARGE);
+
+	return status != ReadStatus::UNREADABLE;
 }
 
-Lexer::~Lexer()
+void Lexer::Reset(const char* source, std::size_t size)
+{
+	// An oversized source is never copied
+	const bool isOverBudget = ExceedsLimit(size, m_options.maxMemoryBytes);
+
+	m_source.assign(source, isOverBudget ? 0 : size);
+
+	ResetSource(isOverBudget);
+}
+
+void Lexer::Reset(std::string& source)
+{
+	m_source.swap(source);
+
+	ResetSource(ExceedsLimit(m_source.size(), m_options.maxMemoryBytes));
+}
+
+std::size_t Lexer::GetLineStart()
+{
+	const std::vector<std::size_t>& lineStarts = m_lineIndex.GetLineStarts();
+
+	// Tokens only move forward, so the cursor never has to search
+	while (m_nextLine < lineStarts.size() && lineStarts[m_nextLine] <= m_tokenOffset)
+	{
+		++m_nextLine;
+	}
+
+	return lineStarts[m_nextLine - 1];
+}
+
+void Lexer::ResetSource(bool isOverBudget)
+{
+	m_stats = LexerStats();
+	m_isAbortPending = false;
+
+	// An oversized source is dropped before it is validated or lexed
+	if (isOverBudget)
+	{
+		m_stats.abortReason = LexerAbort::MEMORY_BUDGET;
+		m_isAbortPending = true;
+
+		m_source.clear();
+	}
+
+	// Validating once up front lets strings and comments skip bytes >= 0x80 unchecked
+	const std::size_t validLength = ValidateUtf8(m_source.data(), m_source.size());
+
+	// Tokens are spans of the source, which ends in a null character at the first ill-formed sequence
+	if (validLength < m_source.size())
+	{
+		m_stats.abortReason = LexerAbort::INVALID_UTF8;
+		m_isAbortPending = true;
+	}
+	m_source.resize(validLength);
+	m_sourceEnd = m_source.data() + m_source.size();
+
+	m_tokenHead = m_tokenIter = &m_source[0];
+	m_lineIndex.Reset(m_source.data(), m_source.size());
+	m_nextLine = 1;
+	m_tokenOffset = 0;
+	m_tokenLength = 0;
+	m_tokenCount = 0;
+	m_trivia.clear();
+	m_nestingDepth = 0;
+
+	UpdatePeakBytes();
+}
+
+void Lexer::AddTrivia(TriviaKind kind)
+{
+	m_trivia.push_back({
+		static_cast<std::uint32_t>(m_tokenHead - m_source.data()),
+		static_cast<std::uint32_t>(m_tokenIter - m_tokenHead),
+		static_cast<std::uint32_t>(m_tokenCount),
+		kind });
+
+	UpdatePeakBytes();
+}
+
+void Lexer::UpdatePeakBytes()
 {
-	delete m_lineBuffer;
+	if (GetFootprint() > m_stats.peakBytes)
+	{
+		m_stats.peakBytes = GetFootprint();
+
+		if (ExceedsLimit(m_stats.peakBytes, m_options.maxMemoryBytes))
+		{
+			Abort(LexerAbort::MEMORY_BUDGET);
+		}
+	}
+}
+
+void Lexer::Abort(LexerAbort reason)
+{
+	m_stats.abortReason = reason;
+	m_isAbortPending = true;
+
+	// Shrinking keeps the storage, so the line index and earlier offsets stay valid
+	m_source.resize(m_tokenIter - m_source.data());
+	m_sourceEnd = m_tokenIter;
+}
+
+Token* Lexer::GetToken(const TerminalSet& acceptable)
+{
+	m_acceptable = &acceptable;
+	Token* token = GetToken();
+	m_acceptable = nullptr;
+
+	return token;
 }
 
 Token* Lexer::GetToken()
@@ -628,36 +721,57 @@ Token* Lexer::GetToken()
 	assert(m_tokenIter != nullptr);
 
 	Token* token = new Token();
+	Symbol symbol;
 
-CHECK:
-	if (*m_tokenHead == '\0')
+SKIP_TRIVIA:
+	while (+(m_symbolMap[static_cast<unsigned char>(*m_tokenIter)] & (Symbol::BLANK | Symbol::NEWLINE)))
 	{
-		if (m_sourceFile.get(m_lineBuffer, m_lineBufferSize))
+		++m_tokenIter;
+	}
+
+	if (m_options.triviaMode == TriviaMode::RECORD && m_tokenIter != m_tokenHead)
+	{
+		AddTrivia(TriviaKind::WHITESPACE);
+	}
+	m_tokenHead = m_tokenIter;
+	m_tokenOffset = m_tokenHead - m_source.data();
+
+	if (m_tokenIter == m_sourceEnd)
+	{
+		// Lexing stops at the first ill-formed UTF-8 sequence, or where a budget ran out
+		if (m_isAbortPending)
 		{
-			m_tokenIter = m_tokenHead = m_lineBuffer;
-			++m_lineNumber;
+			token->token = TokenType::ERROR;
+			m_isAbortPending = false;
+
+			// TODO: Report the error
 		}
 		else
 		{
 			token->token = TokenType::END_OF_FILE;
-			goto EXIT_FUNC;
 		}
-	}
 
-	while (+((CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_tokenIter)] & Symbol::BLANK | Symbol::NEWLINE)))
-	{
-		++m_tokenIter;
+		goto EXIT_FUNC;
 	}
-	m_tokenHead = m_tokenIter;
 
-	if (*m_tokenIter == '\0')
+	if (m_options.maxLineLength != 0 && ExceedsLimit(m_tokenOffset - GetLineStart() + 1, m_options.maxLineLength))
 	{
-		goto CHECK;
+		// The rest of an overlong line is a single error token
+		while (*m_tokenIter != '\n' && m_tokenIter != m_sourceEnd)
+		{
+			++m_tokenIter;
+		}
+
+		token->token = TokenType::ERROR;
+
+		// TODO: Report the error
+
+		goto EXIT_FUNC;
 	}
 
-	const Symbol symbol = CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_tokenIter)];
+	symbol = m_symbolMap[static_cast<unsigned char>(*m_tokenIter)];
 
-	if (+(symbol & Symbol::LETTER))
+	if (+(symbol & Symbol::LETTER) || MatchXidStart(m_tokenIter, m_sourceEnd) != nullptr)
 	{
 		m_identifierDFA.GetToken(token);
 		goto EXIT_FUNC;
@@ -688,6 +802,20 @@ CHECK:
 		if (*m_tokenIter == '/' || *m_tokenIter == '*')
 		{
 			m_commentDFA.GetToken(token);
+
+			// Unterminated comments still come back as errors
+			if (token->token == TokenType::UNKNOWN && m_options.triviaMode != TriviaMode::AS_TOKENS)
+			{
+				if (m_options.triviaMode == TriviaMode::RECORD)
+				{
+					AddTrivia(m_tokenHead[1] == '/' ? TriviaKind::LINE_COMMENT : TriviaKind::BLOCK_COMMENT);
+				}
+
+				token->token = TokenType::ERROR;
+				m_tokenHead = m_tokenIter;
+
+				goto SKIP_TRIVIA;
+			}
 		}
 		else
 		{
@@ -729,25 +857,49 @@ CHECK:
 		default:	break;
 		}
 
+		if (token->token == TokenType::PUNCT_LPAREN || token->token == TokenType::PUNCT_LBRACK ||
+			token->token == TokenType::PUNCT_LBRACE)
+		{
+			if (ExceedsLimit(++m_nestingDepth, m_options.maxNestingDepth))
+			{
+				// The bracket that nests too deep is reported as the final error
+				Abort(LexerAbort::NESTING_DEPTH);
+				goto SKIP_TRIVIA;
+			}
+
+			if (m_nestingDepth > m_stats.maxNestingDepth)
+			{
+				m_stats.maxNestingDepth = m_nestingDepth;
+			}
+		}
+		else if ((token->token == TokenType::PUNCT_RPAREN || token->token == TokenType::PUNCT_RBRACK ||
+			token->token == TokenType::PUNCT_RBRACE) && m_nestingDepth > 0)
+		{
+			--m_nestingDepth;
+		}
+
 		++m_tokenIter;
 
 		goto EXIT_FUNC;
 	}
 
-	assert(CHAR_TO_SYMBOL_MAP[static_cast<int>(*m_tokenIter)] == Symbol::UNDEFINED);
+	assert(m_symbolMap[static_cast<unsigned char>(*m_tokenIter)] == Symbol::UNDEFINED);
 
 	token->token = TokenType::ERROR;
 	++m_tokenIter;
 
-	// TODO: Report the error
-
-EXIT_FUNC:
-	if (*m_tokenIter == 0xa)
+	// A non-identifier character outside ASCII is reported once, not per byte
+	while ((static_cast<unsigned char>(*m_tokenIter) & 0xc0) == 0x80)
 	{
 		++m_tokenIter;
 	}
 
+	// TODO: Report the error
+
+EXIT_FUNC:
+	m_tokenLength = m_tokenIter - m_tokenHead;
 	m_tokenHead = m_tokenIter;
+	++m_tokenCount;
 
 	return token;
 }
\ No newline at end of file
@@ -1,10 +1,17 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "Keywords.h"
+#include "LineIndex.h"
 #include "Utils.h"
 
+#include <array>
+#include <bitset>
 #include <cassert>
-#include <fstream>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 enum class Symbol : int
 {
@@ -46,6 +53,8 @@ inline Symbol& operator|=(Symbol& lhs, Symbol rhs)
 	return lhs;
 }
 
+extern const std::array<Symbol, 256> CHAR_TO_SYMBOL_MAP;
+
 enum class TokenType
 {
 	// Keywords
@@ -120,6 +129,9 @@ enum class TokenType
 	UNKNOWN
 };
 
+// One bit per TokenType, e.g. the terminals a parser state can shift
+using TerminalSet = std::bitset<static_cast<std::size_t>(TokenType::UNKNOWN) + 1>;
+
 struct Token
 {
 	// Constructors
@@ -157,7 +169,7 @@ struct Token
 			token == TokenType::NUM ||
 			token == TokenType::ID)
 		{
-			delete val.strVal;
+			delete[] val.strVal;
 		}
 	}
 
@@ -196,10 +208,139 @@ struct Token
 	} val;
 };
 
+enum class TriviaMode
+{
+	// Comments come back from GetToken() as UNKNOWN tokens
+	AS_TOKENS,
+
+	// Comments are skipped like whitespace
+	SKIP,
+
+	// Skipped, and recorded along with whitespace in the trivia table
+	RECORD
+};
+
+enum class TriviaKind : std::uint8_t
+{
+	WHITESPACE,
+	LINE_COMMENT,
+	BLOCK_COMMENT
+};
+
+// A run of skipped source text, attached to the token that follows it
+struct Trivia
+{
+	std::uint32_t offset;
+	std::uint32_t length;
+	std::uint32_t tokenIndex;
+	TriviaKind kind;
+};
+
+// Per-lexer limits, measured in bytes; zero means unbounded
+struct LexerOptions
+{
+	std::size_t maxTokenLength = 0;
+	std::size_t maxIdentifierLength = 0;
+	std::size_t maxStringLength = 0;
+	std::size_t maxNumericLength = 0;
+	std::size_t maxLineLength = 0;
+
+	// Bytes held for one source, its copy of the text plus the trivia table
+	std::size_t maxMemoryBytes = 0;
+
+	// Deepest nesting of (), [] and {} before lexing stops
+	std::size_t maxNestingDepth = 0;
+
+	TriviaMode triviaMode = TriviaMode::AS_TOKENS;
+};
+
+enum class LexerAbort
+{
+	NONE,
+	INVALID_UTF8,
+	MEMORY_BUDGET,
+	NESTING_DEPTH
+};
+
+// Accounting for the current source, reset by Lexer::Reset()
+struct LexerStats
+{
+	std::size_t peakBytes;
+	std::size_t maxNestingDepth;
+
+	// Why lexing stopped before the end of the source, reported as a final ERROR token
+	LexerAbort abortReason;
+};
+
+// Immutable language data shared read-only by every lexer of the language
+class LexerSpec
+{
+public:
+	// Keywords of a case-insensitive language match in any letter case
+	explicit LexerSpec(bool isCaseInsensitive = false);
+
+	// Weak keywords are only recognized where the parser can shift them, and are IDs elsewhere
+	LexerSpec(bool isCaseInsensitive, const TerminalSet& weakKeywords);
+
+	// For dialects with their own keywords, see KeywordTable; the table must outlive the spec
+	explicit LexerSpec(const KeywordView& keywords, bool isCaseInsensitive = false,
+		const TerminalSet& weakKeywords = TerminalSet());
+	LexerSpec(const LexerSpec&) = delete;
+	LexerSpec& operator=(const LexerSpec&) = delete;
+
+	// Case-sensitive MinusC, built on first use
+	static std::shared_ptr<const LexerSpec> GetDefault();
+
+	const std::array<Symbol, 256>& GetSymbolMap() const
+	{
+		return m_symbolMap;
+	}
+
+	// Returns TokenType::ID when the string is not a keyword
+	TokenType GetKeyword(const char* str, std::size_t length) const;
+
+	const KeywordView& GetKeywords() const
+	{
+		return m_keywords;
+	}
+
+	bool IsCaseInsensitive() const
+	{
+		return m_isCaseInsensitive;
+	}
+
+	const TerminalSet& GetKeywordSet() const
+	{
+		return m_keywordSet;
+	}
+
+	const TerminalSet& GetWeakKeywords() const
+	{
+		return m_weakKeywords;
+	}
+
+	const TerminalSet& GetStrongKeywords() const
+	{
+		return m_strongKeywords;
+	}
+
+private:
+	std::array<Symbol, 256> m_symbolMap;
+	KeywordView m_keywords;
+	bool m_isCaseInsensitive;
+
+	TerminalSet m_keywordSet;
+	TerminalSet m_weakKeywords;
+	TerminalSet m_strongKeywords;
+};
+
 class Lexer
 {
 public:
-	explicit Lexer(const char* fileName);
+	explicit Lexer(const char* fileName, const LexerOptions& options = LexerOptions());
+
+	// Starts at END_OF_FILE until Reset() supplies a source
+	explicit Lexer(std::shared_ptr<const LexerSpec> spec, const LexerOptions& options = LexerOptions());
 	virtual ~Lexer();
 	Lexer(const Lexer&) = delete;
 	Lexer(Lexer&&) = delete;
@@ -208,9 +349,63 @@ public:
 
 	virtual Token* GetToken();
 
+	// Weak keywords outside the set come back as IDs, every other token is returned as usual
+	Token* GetToken(const TerminalSet& acceptable);
+
+	// Rewinds onto a new source, reusing the storage of the previous one
+	// False if the file cannot be read, which leaves an empty source
+	bool Reset(const char* fileName);
+	void Reset(const char* source, std::size_t size);
+
+	// Takes over source without copying, handing back the previous buffer for reuse
+	void Reset(std::string& source);
+
+	// Line of the last token, the line index is built on the first call after a reset
 	int GetLineNumber() const
 	{
-		return m_lineNumber;
+		return static_cast<int>(m_lineIndex.GetLine(m_tokenOffset));
+	}
+
+	std::size_t GetLine(std::size_t offset) const
+	{
+		return m_lineIndex.GetLine(offset);
+	}
+
+	SourceLocation GetLocation(std::size_t offset) const
+	{
+		return m_lineIndex.GetLocation(offset);
+	}
+
+	// Byte offset and length of the last token returned by GetToken()
+	std::size_t GetTokenOffset() const
+	{
+		return m_tokenOffset;
+	}
+
+	std::size_t GetTokenLength() const
+	{
+		return m_tokenLength;
+	}
+
+	const LexerOptions& GetOptions() const
+	{
+		return m_options;
+	}
+
+	const LexerStats& GetStats() const
+	{
+		return m_stats;
+	}
+
+	// Filled only in TriviaMode::RECORD, in source order; cleared by Reset()
+	const std::vector<Trivia>& GetTrivia() const
+	{
+		return m_trivia;
+	}
+
+	const LexerSpec& GetSpec() const
+	{
+		return *m_spec;
 	}
 
 protected:
@@ -240,8 +435,6 @@ protected:
 
 	private:
 		Lexer& m_lexer;
-
-		static int m_strMaxLength;
 	};
 
 	class CharDFA
@@ -257,8 +450,7 @@ protected:
 	private:
 		Lexer& m_lexer;
 
-		static int m_charSeqMaxLength;
-		static char m_reservedEscSeq[10];
+		static const int m_charSeqMaxLength = 4;
 	};
 	
 	class NumericsDFA
@@ -273,9 +465,6 @@ protected:
 
 	private:
 		Lexer& m_lexer;
-
-		static int m_wordLength;
-		static unsigned int m_bufferMaxSize;
 	};
 
 	class IdentifierDFA
@@ -283,22 +472,13 @@ protected:
 	public:
 		explicit IdentifierDFA(Lexer& lexer) : m_lexer(lexer)
 		{
-			m_hashKeywords.Build(m_keywords);
-		}
 
-		void GetToken(Token* token);
-
-		const char* GetKeyword(const char* str)
-		{
-			return m_hashKeywords.Match(str);
 		}
 
+		void GetToken(Token* token) const;
+
 	private:
 		Lexer& m_lexer;
-		HashingTab m_hashKeywords;
-		
-		static int m_idMaxLength;
-		static const char* m_keywords[];
 	};
 
 	IdentifierDFA m_identifierDFA;
@@ -308,17 +488,70 @@ protected:
 	CommentDFA m_commentDFA;
 
 private:
-	std::ifstream m_sourceFile;
-	char* m_lineBuffer;
-	char* m_lineBufferTail;
+	bool ExceedsLimit(std::size_t length, std::size_t limit) const
+	{
+		return limit != 0 && length > limit;
+	}
+
+	// An over-budget source is dropped and reported as MEMORY_BUDGET
+	void ResetSource(bool isOverBudget);
+
+	// Records the text between the token head and the iterator
+	void AddTrivia(TriviaKind kind);
+
+	// Cuts the source off at the iterator, so the next token is an error and then END_OF_FILE
+	void Abort(LexerAbort reason);
+
+	// Raises the peak to the current footprint, aborting once it is over the budget
+	void UpdatePeakBytes();
+
+	// Storage kept from earlier sources is not charged to the current one
+	std::size_t GetFootprint() const
+	{
+		return m_source.size() + m_trivia.size() * sizeof(Trivia);
+	}
+
+	// Start of the line holding the current token, only needed for the line length limit
+	std::size_t GetLineStart();
+
+	bool IsAcceptable(TokenType token) const
+	{
+		return m_acceptable == nullptr || m_acceptable->test(static_cast<std::size_t>(token));
+	}
+
+	// Strong keywords are always looked up so they are never mistaken for IDs
+	bool IsKeywordPossible() const
+	{
+		return m_acceptable == nullptr || m_spec->GetStrongKeywords().any() ||
+			(*m_acceptable & m_spec->GetKeywordSet()).any();
+	}
+
+	std::shared_ptr<const LexerSpec> m_spec;
+	const std::array<Symbol, 256>& m_symbolMap;
+	LexerOptions m_options;
+
+	std::string m_source;
+	const char* m_sourceEnd;
+	bool m_isAbortPending;
 
 	char* m_tokenHead;
 	char* m_tokenIter;
 
-	static int m_lineBufferSize;
-	static unsigned int m_tokenMaxLength;
+	LineIndex m_lineIndex;
+	std::size_t m_nextLine;
+
+	std::size_t m_tokenOffset;
+	std::size_t m_tokenLength;
+
+	// Tokens returned since the last reset
+	std::size_t m_tokenCount;
+	std::vector<Trivia> m_trivia;
+
+	std::size_t m_nestingDepth;
+	LexerStats m_stats;
 
-	int m_lineNumber;
+	// Terminals the parser can shift in its current state, nullptr if unrestricted
+	const TerminalSet* m_acceptable;
 };
 
 #endif
\ No newline at end of file
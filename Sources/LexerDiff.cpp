@@ -0,0 +1,288 @@
+#include "LexerDiff.h"
+#include "TokenPipeline.h"
+#include "TokenStream.h"
+#include "Utf8.h"
+
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+	LexerOptions WithTriviaMode(LexerOptions options, TriviaMode triviaMode)
+	{
+		options.triviaMode = triviaMode;
+		return options;
+	}
+
+	bool IsWordStart(const LexerSpec& spec, const char* data, std::size_t size, std::size_t offset)
+	{
+		return offset < size && (+(spec.GetSymbolMap()[static_cast<unsigned char>(data[offset])] & Symbol::LETTER) ||
+			MatchXidStart(data + offset, data + size) != nullptr);
+	}
+
+	const char* const FRAGMENTS[] =
+	{
+		"int", "while", "writex", "x", "_a1", "\xc3\xa9t\xc3\xa9", "\xe4\xb8\xad",
+		"0", "123", "1.5", "1.", "2E+3", "4E", "12ab",
+		"'a'", "'\\n'", "'\\q'", "'ab", "'",
+		"\"str\"", "\"unterminated", "\"",
+		"/* c */", "/*", "*/", "// line", "/",
+		"==", "!=", "<=", ">=", "&&", "||", "&", "|", "!", "=", "<", ">",
+		"(", ")", "{", "}", "[", "]", ";", ",", ":", "+", "-", "*", "%",
+		" ", "\t", "\r", "\n", "\n\n",
+		"\xff", "\x80", "\xc3", "\xe2\x80\xa8", "$", "@"
+	};
+
+	const std::size_t NUM_FRAGMENTS = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+
+	void AppendFragment(std::mt19937& random, std::string& input)
+	{
+		// NUL has no place in a C string table
+		if (random() % 32 == 0)
+		{
+			input.push_back('\0');
+		}
+		else
+		{
+			input += FRAGMENTS[random() % NUM_FRAGMENTS];
+		}
+	}
+}
+
+LexerDiff::LexerDiff(std::shared_ptr<const LexerSpec> spec, const LexerOptions& options, bool isPipelineChecked) :
+	m_spec(spec), m_options(options), m_isPipelineChecked(isPipelineChecked),
+	m_reference(spec, WithTriviaMode(options, TriviaMode::AS_TOKENS)),
+	m_skipping(spec, WithTriviaMode(options, TriviaMode::SKIP)),
+	m_recording(spec, WithTriviaMode(options, TriviaMode::RECORD)),
+	m_weakened(std::make_shared<const LexerSpec>(spec->GetKeywords(), spec->IsCaseInsensitive(), spec->GetKeywordSet()),
+		WithTriviaMode(options, TriviaMode::AS_TOKENS))
+{
+	const TerminalSet& keywords = spec->GetKeywordSet();
+	bool isLeftOut = false;
+
+	m_restrictedTerminals[0].set();
+
+	for (std::size_t token = 0; token < keywords.size(); ++token)
+	{
+		if (keywords.test(token))
+		{
+			m_restrictedTerminals[0].set(token, !isLeftOut);
+			isLeftOut = !isLeftOut;
+		}
+	}
+
+	m_restrictedTerminals[1] = m_restrictedTerminals[0] & ~keywords;
+}
+
+bool LexerDiff::Check(const char* data, std::size_t size, LexerDivergence& divergence)
+{
+	m_reference.Reset(data, size);
+	Lex(m_reference, nullptr, m_expected);
+
+	m_skipping.Reset(data, size);
+	Lex(m_skipping, nullptr, m_actual);
+	if (!Compare("trivia skipping", divergence))
+	{
+		return false;
+	}
+
+	// Recorded trivia counts against the memory budget, so under one the
+	// recording lexer legitimately aborts earlier than the reference
+	if (m_options.maxMemoryBytes == 0)
+	{
+		m_recording.Reset(data, size);
+		Lex(m_recording, nullptr, m_actual);
+		if (!Compare("trivia recording", divergence))
+		{
+			return false;
+		}
+	}
+
+	// The packed stream drops comments like the comparison does
+	PackedTokenWriter writer;
+	m_reference.Reset(data, size);
+	writer.Append(m_reference);
+	const std::vector<std::uint8_t> stream = writer.Finish();
+
+	PackedTokenReader reader;
+	PackedToken packed;
+	m_actual.clear();
+
+	if (reader.Open(stream.data(), stream.size(), data, size))
+	{
+		while (reader.Next(packed))
+		{
+			m_actual.push_back({ packed.token, packed.offset, packed.length });
+		}
+	}
+
+	if (!Compare("packed token stream", divergence))
+	{
+		return false;
+	}
+
+	if (m_isPipelineChecked)
+	{
+		Lexer lexer(m_spec, WithTriviaMode(m_options, TriviaMode::AS_TOKENS));
+		lexer.Reset(data, size);
+
+		TokenPipeline pipeline(lexer);
+		m_actual.clear();
+
+		while (true)
+		{
+			Token* token = pipeline.GetToken();
+			const TokenType type = token->token;
+			delete token;
+
+			m_actual.push_back({ type, pipeline.GetTokenOffset(), pipeline.GetTokenLength() });
+
+			if (type == TokenType::END_OF_FILE)
+			{
+				break;
+			}
+		}
+
+		if (!Compare("token pipeline", divergence))
+		{
+			return false;
+		}
+	}
+
+	// Comes last, since it rewrites the expected tokens in place; a dialect keyword can share its TokenType
+	// with an operator, so only tokens spelled like words are rewritten
+	for (const TerminalSet& acceptable : m_restrictedTerminals)
+	{
+		for (LexedToken& expected : m_expected)
+		{
+			if (m_spec->GetKeywordSet().test(static_cast<std::size_t>(expected.token)) &&
+				!acceptable.test(static_cast<std::size_t>(expected.token)) &&
+				IsWordStart(*m_spec, data, size, expected.offset))
+			{
+				expected.token = TokenType::ID;
+			}
+		}
+
+		m_weakened.Reset(data, size);
+		Lex(m_weakened, &acceptable, m_actual);
+		if (!Compare("parser-directed lexing", divergence))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool LexerDiff::CheckGenerated(std::uint32_t seed, std::size_t count, LexerDivergence& divergence, std::string& input)
+{
+	// The engine's output is specified by the standard, unlike the distributions
+	std::mt19937 random(seed);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		input.clear();
+
+		switch (random() % 4)
+		{
+		case 0:
+			// A line of exactly 2048 bytes before its newline, the size of the old read buffer
+			while (input.size() < 2048)
+			{
+				AppendFragment(random, input);
+			}
+
+			input.resize(2048, ' ');
+			for (char& ch : input)
+			{
+				ch = ch == '\n' ? ' ' : ch;
+			}
+
+			input += '\n';
+			AppendFragment(random, input);
+			break;
+
+		case 1:
+			// Ends inside a string or a comment
+			for (std::uint32_t j = random() % 16; j > 0; --j)
+			{
+				AppendFragment(random, input);
+			}
+
+			input += random() % 2 == 0 ? "\"abc" : "/* abc\n";
+			break;
+
+		default:
+			for (std::uint32_t j = random() % 64 + 1; j > 0; --j)
+			{
+				AppendFragment(random, input);
+			}
+			break;
+		}
+
+		if (!Check(input.data(), input.size(), divergence))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void LexerDiff::Lex(Lexer& lexer, const TerminalSet* acceptable, std::vector<LexedToken>& tokens)
+{
+	tokens.clear();
+
+	while (true)
+	{
+		Token* token = acceptable != nullptr ? lexer.GetToken(*acceptable) : lexer.GetToken();
+		const TokenType type = token->token;
+		delete token;
+
+		if (type == TokenType::UNKNOWN)
+		{
+			continue;
+		}
+
+		tokens.push_back({ type, lexer.GetTokenOffset(), lexer.GetTokenLength() });
+
+		if (type == TokenType::END_OF_FILE)
+		{
+			break;
+		}
+	}
+}
+
+bool LexerDiff::Compare(const char* backEnd, LexerDivergence& divergence) const
+{
+	const LexedToken missing = { TokenType::UNKNOWN, 0, 0 };
+
+	for (std::size_t i = 0; i < m_expected.size() || i < m_actual.size(); ++i)
+	{
+		const LexedToken& expected = i < m_expected.size() ? m_expected[i] : missing;
+		const LexedToken& actual = i < m_actual.size() ? m_actual[i] : missing;
+
+		if (expected.token != actual.token || expected.offset != actual.offset || expected.length != actual.length)
+		{
+			divergence = { backEnd, i, expected, actual };
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int LexerDiffFuzzOne(const std::uint8_t* data, std::size_t size)
+{
+	// Thread-per-input would dominate a fuzzer's run time
+	static LexerDiff diff(LexerSpec::GetDefault(), LexerOptions(), false);
+
+	LexerDivergence divergence;
+
+	if (!diff.Check(reinterpret_cast<const char*>(data), size, divergence))
+	{
+		std::abort();
+	}
+
+	return 0;
+}
\ No newline at end of file
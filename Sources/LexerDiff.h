@@ -0,0 +1,70 @@
+#ifndef LEXER_DIFF_H
+#define LEXER_DIFF_H
+
+#include "Lexer.h"
+
+#include <cstdint>
+
+struct LexedToken
+{
+	TokenType token;
+	std::size_t offset;
+	std::size_t length;
+};
+
+struct LexerDivergence
+{
+	const char* backEnd;
+
+	// Position in the token sequence, comments not counted
+	std::size_t index;
+
+	// A sequence that ends early shows UNKNOWN in place of the missing token
+	LexedToken expected;
+	LexedToken actual;
+};
+
+// Lexes the same bytes through every lexing path and compares each with plain Lexer::GetToken():
+// skipped and recorded trivia, the packed token stream, optionally the threaded TokenPipeline,
+// and parser-directed lexing with every keyword made weak and some or all of them left out
+// of the acceptable set, which must turn exactly those keywords into IDs.
+// Recorded trivia is only compared without a memory budget.
+class LexerDiff
+{
+public:
+	explicit LexerDiff(std::shared_ptr<const LexerSpec> spec = LexerSpec::GetDefault(),
+		const LexerOptions& options = LexerOptions(), bool isPipelineChecked = true);
+
+	// Returns false at the first token where any back end disagrees with the reference
+	bool Check(const char* data, std::size_t size, LexerDivergence& divergence);
+
+	// Checks count generated inputs built around known edge cases: NUL bytes, ill-formed UTF-8,
+	// lines of exactly 2048 bytes, unterminated strings and comments. The same seed
+	// produces the same inputs, and input holds the one that diverged.
+	bool CheckGenerated(std::uint32_t seed, std::size_t count, LexerDivergence& divergence, std::string& input);
+
+private:
+	void Lex(Lexer& lexer, const TerminalSet* acceptable, std::vector<LexedToken>& tokens);
+	bool Compare(const char* backEnd, LexerDivergence& divergence) const;
+
+	std::shared_ptr<const LexerSpec> m_spec;
+	LexerOptions m_options;
+	bool m_isPipelineChecked;
+
+	Lexer m_reference;
+	Lexer m_skipping;
+	Lexer m_recording;
+	Lexer m_weakened;
+
+	// Each set leaves out more keywords than the one before
+	std::array<TerminalSet, 2> m_restrictedTerminals;
+
+	std::vector<LexedToken> m_expected;
+	std::vector<LexedToken> m_actual;
+};
+
+// For libFuzzer and AFL drivers, which only need to forward their input:
+// aborts on the first divergence, returns 0 otherwise
+int LexerDiffFuzzOne(const std::uint8_t* data, std::size_t size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "LexerReport.h"
+
+#include <algorithm>
+
+namespace
+{
+	const char* TOKEN_TYPE_NAMES[] =
+	{
+		"KEYWORD_INT", "KEYWORD_CHAR", "KEYWORD_DOUBLE", "KEYWORD_VOID",
+		"KEYWORD_IF", "KEYWORD_ELSE", "KEYWORD_WHILE", "KEYWORD_FOR",
+		"KEYWORD_BREAK", "KEYWORD_CONTINUE", "KEYWORD_GOTO", "KEYWORD_RETURN",
+		"KEYWORD_READ", "KEYWORD_WRITE",
+		"OP_ASSIGN", "OP_ADD", "OP_SUB", "OP_MUL", "OP_DIV", "OP_MOD",
+		"OP_NOT", "OP_AND", "OP_OR", "OP_EQUAL", "OP_NOTEQUAL",
+		"OP_LESSTHAN", "OP_GREATERTHAN", "OP_LESSTHANEQUAL", "OP_GREATERTHANEQUAL",
+		"PUNCT_COMMA", "PUNCT_SEMICOLON", "PUNCT_COLON",
+		"PUNCT_LPAREN", "PUNCT_RPAREN", "PUNCT_LBRACE", "PUNCT_RBRACE",
+		"PUNCT_LBRACK", "PUNCT_RBRACK",
+		"ID", "NUM_INT", "NUM_DOUBLE", "NUM", "CHAR", "STRING_LITERAL",
+		"END_OF_FILE", "ERROR", "UNKNOWN"
+	};
+
+	static_assert(sizeof(TOKEN_TYPE_NAMES) / sizeof(TOKEN_TYPE_NAMES[0]) == static_cast<std::size_t>(TokenType::UNKNOWN) + 1,
+		"TOKEN_TYPE_NAMES must list every TokenType");
+
+	const char* ABORT_REASON_NAMES[] =
+	{
+		"NONE", "INVALID_UTF8", "MEMORY_BUDGET", "NESTING_DEPTH"
+	};
+
+	static_assert(sizeof(ABORT_REASON_NAMES) / sizeof(ABORT_REASON_NAMES[0]) == static_cast<std::size_t>(LexerAbort::NESTING_DEPTH) + 1,
+		"ABORT_REASON_NAMES must list every LexerAbort");
+
+	void WriteJsonString(std::ostream& out, const std::string& str)
+	{
+		static const char HEX_DIGITS[] = "0123456789abcdef";
+
+		out << '"';
+
+		for (char ch : str)
+		{
+			if (ch == '"' || ch == '\\')
+			{
+				out << '\\' << ch;
+			}
+			else if (static_cast<unsigned char>(ch) < 0x20)
+			{
+				out << "\\u00" << HEX_DIGITS[ch >> 4] << HEX_DIGITS[ch & 0xf];
+			}
+			else
+			{
+				out << ch;
+			}
+		}
+
+		out << '"';
+	}
+
+	double GetBytesPerSecond(std::size_t bytes, std::chrono::microseconds elapsed)
+	{
+		return elapsed.count() > 0 ? bytes * 1e6 / elapsed.count() : 0.0;
+	}
+}
+
+const char* GetTokenTypeName(TokenType token)
+{
+	return TOKEN_TYPE_NAMES[static_cast<std::size_t>(token)];
+}
+
+LexerReport::LexerReport(std::shared_ptr<const LexerSpec> spec, const LexerOptions& options) :
+	m_lexer(std::move(spec), options)
+{
+
+}
+
+const LexerFileReport& LexerReport::AddFile(const char* fileName)
+{
+	LexerFileReport report;
+
+	report.fileName = fileName;
+	report.tokenCount = 0;
+	report.tokenCounts.fill(0);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	report.isRead = m_lexer.Reset(fileName);
+
+	while (report.isRead)
+	{
+		Token* token = m_lexer.GetToken();
+		const TokenType type = token->token;
+		delete token;
+
+		++report.tokenCounts[static_cast<std::size_t>(type)];
+		++report.tokenCount;
+
+		if (type == TokenType::END_OF_FILE)
+		{
+			break;
+		}
+	}
+
+	report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	report.bytes = m_lexer.GetTokenOffset();
+	report.stats = m_lexer.GetStats();
+
+	m_files.push_back(report);
+
+	return m_files.back();
+}
+
+void LexerReport::WriteJson(std::ostream& out) const
+{
+	std::size_t unreadableFiles = 0;
+	std::size_t totalBytes = 0;
+	std::size_t totalTokens = 0;
+	std::size_t peakBytes = 0;
+	std::size_t maxNestingDepth = 0;
+	std::chrono::microseconds totalElapsed(0);
+
+	out << "{\n\t\"files\": [";
+
+	for (std::size_t i = 0; i < m_files.size(); ++i)
+	{
+		const LexerFileReport& file = m_files[i];
+
+		out << (i == 0 ? "\n" : ",\n") << "\t\t{\n\t\t\t\"name\": ";
+		WriteJsonString(out, file.fileName);
+		out << ",\n\t\t\t\"isRead\": " << (file.isRead ? "true" : "false") <<
+			",\n\t\t\t\"bytes\": " << file.bytes <<
+			",\n\t\t\t\"tokens\": " << file.tokenCount <<
+			",\n\t\t\t\"microseconds\": " << file.elapsed.count() <<
+			",\n\t\t\t\"bytesPerSecond\": " << GetBytesPerSecond(file.bytes, file.elapsed) <<
+			",\n\t\t\t\"peakBytes\": " << file.stats.peakBytes <<
+			",\n\t\t\t\"maxNestingDepth\": " << file.stats.maxNestingDepth <<
+			",\n\t\t\t\"abortReason\": \"" << ABORT_REASON_NAMES[static_cast<int>(file.stats.abortReason)] << "\"" <<
+			",\n\t\t\t\"tokenCounts\": {";
+
+		// Only token types that occur, most frequent first
+		std::vector<std::size_t> types;
+		for (std::size_t type = 0; type < file.tokenCounts.size(); ++type)
+		{
+			if (file.tokenCounts[type] != 0)
+			{
+				types.push_back(type);
+			}
+		}
+
+		std::stable_sort(types.begin(), types.end(),
+			[&file](std::size_t lhs, std::size_t rhs) { return file.tokenCounts[lhs] > file.tokenCounts[rhs]; });
+
+		for (std::size_t j = 0; j < types.size(); ++j)
+		{
+			out << (j == 0 ? " \"" : ", \"") << TOKEN_TYPE_NAMES[types[j]] << "\": " << file.tokenCounts[types[j]];
+		}
+
+		out << " }\n\t\t}";
+
+		unreadableFiles += file.isRead ? 0 : 1;
+		totalBytes += file.bytes;
+		totalTokens += file.tokenCount;
+		totalElapsed += file.elapsed;
+		peakBytes = std::max(peakBytes, file.stats.peakBytes);
+		maxNestingDepth = std::max(maxNestingDepth, file.stats.maxNestingDepth);
+	}
+
+	out << (m_files.empty() ? "],\n" : "\n\t],\n") <<
+		"\t\"totals\": {\n" <<
+		"\t\t\"files\": " << m_files.size() <<
+		",\n\t\t\"unreadableFiles\": " << unreadableFiles <<
+		",\n\t\t\"bytes\": " << totalBytes <<
+		",\n\t\t\"tokens\": " << totalTokens <<
+		",\n\t\t\"microseconds\": " << totalElapsed.count() <<
+		",\n\t\t\"bytesPerSecond\": " << GetBytesPerSecond(totalBytes, totalElapsed) <<
+		",\n\t\t\"peakBytes\": " << peakBytes <<
+		",\n\t\t\"maxNestingDepth\": " << maxNestingDepth <<
+		"\n\t}\n}\n";
+}
\ No newline at end of file
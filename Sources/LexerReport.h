@@ -0,0 +1,49 @@
+#ifndef LEXER_REPORT_H
+#define LEXER_REPORT_H
+
+#include "Lexer.h"
+
+#include <chrono>
+#include <ostream>
+
+struct LexerFileReport
+{
+	std::string fileName;
+
+	// False when the file could not be opened, nothing was lexed then
+	bool isRead;
+
+	// Bytes lexed, fewer than the file holds when lexing stopped early
+	std::size_t bytes;
+	std::size_t tokenCount;
+	std::chrono::microseconds elapsed;
+	LexerStats stats;
+
+	// Indexed by TokenType, comments count as UNKNOWN
+	std::array<std::size_t, static_cast<std::size_t>(TokenType::UNKNOWN) + 1> tokenCounts;
+};
+
+// Lexes benchmark files and writes sizes, timings and budgets as JSON, so CI can gate on them
+class LexerReport
+{
+public:
+	explicit LexerReport(std::shared_ptr<const LexerSpec> spec = LexerSpec::GetDefault(),
+		const LexerOptions& options = LexerOptions());
+
+	const LexerFileReport& AddFile(const char* fileName);
+
+	const std::vector<LexerFileReport>& GetFiles() const
+	{
+		return m_files;
+	}
+
+	void WriteJson(std::ostream& out) const;
+
+private:
+	Lexer m_lexer;
+	std::vector<LexerFileReport> m_files;
+};
+
+const char* GetTokenTypeName(TokenType token);
+
+#endif
\ No newline at end of file
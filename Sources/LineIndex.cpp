@@ -0,0 +1,91 @@
+#include "LineIndex.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LINE_INDEX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+LineIndex::LineIndex() :
+	m_source(nullptr), m_size(0), m_isBuilt(false)
+{
+
+}
+
+void LineIndex::Reset(const char* source, std::size_t size)
+{
+	m_source = source;
+	m_size = size;
+	m_isBuilt = false;
+}
+
+std::size_t LineIndex::GetLine(std::size_t offset) const
+{
+	assert(offset <= m_size);
+
+	const std::vector<std::size_t>& lineStarts = GetLineStarts();
+
+	return std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+}
+
+SourceLocation LineIndex::GetLocation(std::size_t offset) const
+{
+	const std::size_t line = GetLine(offset);
+	const std::vector<std::size_t>& lineStarts = GetLineStarts();
+
+	// Continuation bytes do not start a code point
+	std::size_t column = 1;
+	for (std::size_t i = lineStarts[line - 1]; i < offset; ++i)
+	{
+		column += (static_cast<unsigned char>(m_source[i]) & 0xc0) != 0x80;
+	}
+
+	return { line, column };
+}
+
+const std::vector<std::size_t>& LineIndex::GetLineStarts() const
+{
+	if (!m_isBuilt)
+	{
+		Build();
+	}
+
+	return m_lineStarts;
+}
+
+void LineIndex::Build() const
+{
+	std::size_t i = 0;
+
+	m_lineStarts.assign(1, 0);
+
+#if defined(LINE_INDEX_USE_SSE2)
+	// Compares 16 bytes at a time and visits only the set bits of the match mask
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	for (; m_size - i >= 16; i += 16)
+	{
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_source + i));
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+
+		while (mask != 0)
+		{
+			m_lineStarts.push_back(i + CountTrailingZeros(mask) + 1);
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; i < m_size; ++i)
+	{
+		if (m_source[i] == '\n')
+		{
+			m_lineStarts.push_back(i + 1);
+		}
+	}
+
+	m_isBuilt = true;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+struct SourceLocation
+{
+	// Both one-based, the column counts code points from the start of the line
+	std::size_t line;
+	std::size_t column;
+};
+
+// Maps byte offsets to lines and columns. Line starts are found on first use,
+// so lexing pays nothing for positions nobody asks about.
+class LineIndex
+{
+public:
+	LineIndex();
+
+	// The source must outlive the index and stay unchanged
+	void Reset(const char* source, std::size_t size);
+
+	// One-based line only, a binary search without the column scan
+	std::size_t GetLine(std::size_t offset) const;
+
+	SourceLocation GetLocation(std::size_t offset) const;
+
+	// Offsets of the first byte of every line, the first one is always 0
+	const std::vector<std::size_t>& GetLineStarts() const;
+
+private:
+	void Build() const;
+
+	const char* m_source;
+	std::size_t m_size;
+
+	mutable std::vector<std::size_t> m_lineStarts;
+	mutable bool m_isBuilt;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "ReadAhead.h"
+#include "Utils.h"
+
+#include <cassert>
+
+const std::size_t ReadAhead::DEFAULT_WINDOW;
+const std::size_t ReadAhead::DEFAULT_NUM_THREADS;
+
+ReadAhead::ReadAhead(std::vector<std::string> fileNames, std::size_t window, std::size_t numThreads) :
+	m_fileNames(std::move(fileNames)), m_slots(window),
+	m_nextRead(0), m_nextDelivery(0), m_isStopped(false)
+{
+	assert(window > 0 && numThreads > 0);
+
+	for (Slot& slot : m_slots)
+	{
+		slot.isReady = false;
+		slot.isRead = false;
+	}
+
+	for (std::size_t i = 0; i < numThreads; ++i)
+	{
+		m_threads.emplace_back(&ReadAhead::Read, this);
+	}
+}
+
+ReadAhead::~ReadAhead()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopped = true;
+	}
+
+	m_canRead.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+bool ReadAhead::Next(std::size_t& index, std::string& buffer, bool& isRead)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_nextDelivery == m_fileNames.size())
+	{
+		return false;
+	}
+
+	Slot& slot = m_slots[m_nextDelivery % m_slots.size()];
+	m_isReadable.wait(lock, [&slot] { return slot.isReady; });
+
+	slot.data.swap(buffer);
+	m_spareBuffers.push_back(std::move(slot.data));
+	slot.data.clear();
+	slot.isReady = false;
+
+	isRead = slot.isRead;
+	index = m_nextDelivery++;
+
+	// Handing out a file frees a slot at the far end of the window
+	m_canRead.notify_one();
+
+	return true;
+}
+
+void ReadAhead::Read()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_canRead.wait(lock, [this]
+		{
+			return m_isStopped || m_nextRead == m_fileNames.size() ||
+				m_nextRead < m_nextDelivery + m_slots.size();
+		});
+
+		if (m_isStopped || m_nextRead == m_fileNames.size())
+		{
+			return;
+		}
+
+		const std::size_t index = m_nextRead++;
+
+		std::string buffer;
+		if (!m_spareBuffers.empty())
+		{
+			buffer.swap(m_spareBuffers.back());
+			m_spareBuffers.pop_back();
+		}
+
+		lock.unlock();
+
+		const bool isRead = ReadFile(m_fileNames[index].c_str(), buffer) == ReadStatus::OK;
+
+		lock.lock();
+
+		Slot& slot = m_slots[index % m_slots.size()];
+		slot.data.swap(buffer);
+		slot.isReady = true;
+		slot.isRead = isRead;
+
+		m_isReadable.notify_one();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads a list of files on background threads ahead of the consumer, so lexing
+// overlaps with disk I/O. File buffers are recycled between reads.
+//
+//	std::string source;
+//	while (readAhead.Next(index, source, isRead))
+//	{
+//		lexer.Reset(source);
+//		...
+//	}
+class ReadAhead
+{
+public:
+	static const std::size_t DEFAULT_WINDOW = 8;
+	static const std::size_t DEFAULT_NUM_THREADS = 2;
+
+	// At most window files are read but not yet handed out at any time
+	explicit ReadAhead(std::vector<std::string> fileNames,
+		std::size_t window = DEFAULT_WINDOW, std::size_t numThreads = DEFAULT_NUM_THREADS);
+	~ReadAhead();
+	ReadAhead(const ReadAhead&) = delete;
+	ReadAhead& operator=(const ReadAhead&) = delete;
+
+	// Waits for the next file in list order and swaps its contents into buffer,
+	// recycling what buffer held before. An unreadable file comes back empty with isRead false.
+	// Returns false once every file has been handed out.
+	bool Next(std::size_t& index, std::string& buffer, bool& isRead);
+
+private:
+	struct Slot
+	{
+		std::string data;
+		bool isReady;
+		bool isRead;
+	};
+
+	void Read();
+
+	std::vector<std::string> m_fileNames;
+
+	// File i goes through slot i % window
+	std::vector<Slot> m_slots;
+	std::vector<std::string> m_spareBuffers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_canRead;
+	std::condition_variable m_isReadable;
+
+	std::size_t m_nextRead;
+	std::size_t m_nextDelivery;
+	bool m_isStopped;
+
+	std::vector<std::thread> m_threads;
+};
+
+#endif
\ No newline at end of file
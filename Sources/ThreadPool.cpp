@@ -0,0 +1,144 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(std::size_t numThreads) :
+	m_task(nullptr), m_generation(0), m_remaining(0), m_numActive(0), m_isStopped(false)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (std::size_t i = 0; i < numThreads; ++i)
+	{
+		m_queues.emplace_back(new Queue);
+	}
+
+	for (std::size_t i = 0; i < numThreads; ++i)
+	{
+		m_threads.emplace_back(&WorkStealingPool::Work, this, i);
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopped = true;
+	}
+
+	m_wakeUp.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkStealingPool::Run(std::size_t count, const Task& task)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// A worker still draining the previous run must not pick up indices of this one
+	m_done.wait(lock, [this]() { return m_numActive == 0; });
+
+	// Contiguous blocks keep neighbouring inputs on the same worker until stealing kicks in
+	const std::size_t numQueues = m_queues.size();
+
+	for (std::size_t i = 0; i < numQueues; ++i)
+	{
+		std::lock_guard<std::mutex> queueLock(m_queues[i]->mutex);
+
+		for (std::size_t index = i * count / numQueues; index < (i + 1) * count / numQueues; ++index)
+		{
+			m_queues[i]->indices.push_back(index);
+		}
+	}
+
+	m_task = &task;
+	m_remaining.store(count);
+	++m_generation;
+
+	m_wakeUp.notify_all();
+	m_done.wait(lock, [this]() { return m_remaining.load() == 0 && m_numActive == 0; });
+
+	m_task = nullptr;
+}
+
+void WorkStealingPool::Work(std::size_t worker)
+{
+	std::size_t generation = 0;
+
+	while (true)
+	{
+		const Task* task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [&]() { return m_isStopped || m_generation != generation; });
+
+			if (m_isStopped)
+			{
+				return;
+			}
+
+			generation = m_generation;
+			task = m_task;
+			++m_numActive;
+		}
+
+		std::size_t index;
+
+		while (Pop(worker, index))
+		{
+			(*task)(worker, index);
+
+			if (m_remaining.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_done.notify_all();
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--m_numActive;
+		m_done.notify_all();
+	}
+}
+
+bool WorkStealingPool::Pop(std::size_t worker, std::size_t& index)
+{
+	{
+		Queue& own = *m_queues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+
+		if (!own.indices.empty())
+		{
+			index = own.indices.front();
+			own.indices.pop_front();
+			return true;
+		}
+	}
+
+	// Steal from the far end so the victim keeps the inputs it is about to reach
+	for (std::size_t i = 1; i < m_queues.size(); ++i)
+	{
+		Queue& victim = *m_queues[(worker + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.indices.empty())
+		{
+			index = victim.indices.back();
+			victim.indices.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
\ No newline at end of file
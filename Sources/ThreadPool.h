@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers that each own a deque of task indices and steal from the others when theirs runs dry
+class WorkStealingPool
+{
+public:
+	using Task = std::function<void(std::size_t worker, std::size_t index)>;
+
+	// Zero threads means one per hardware thread
+	explicit WorkStealingPool(std::size_t numThreads = 0);
+	~WorkStealingPool();
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	std::size_t GetNumThreads() const
+	{
+		return m_threads.size();
+	}
+
+	// Calls task for every index in [0, count) and returns once all calls are done.
+	// The worker argument is below GetNumThreads(), so it can select per-thread state.
+	// Runs are not reentrant; call Run() from one thread at a time.
+	void Run(std::size_t count, const Task& task);
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::size_t> indices;
+	};
+
+	void Work(std::size_t worker);
+	bool Pop(std::size_t worker, std::size_t& index);
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wakeUp;
+	std::condition_variable m_done;
+
+	const Task* m_task;
+	std::size_t m_generation;
+	std::atomic<std::size_t> m_remaining;
+	std::size_t m_numActive;
+	bool m_isStopped;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "TokenPipeline.h"
+
+#include <algorithm>
+
+const std::size_t TokenPipeline::MIN_BATCH_SIZE;
+const std::size_t TokenPipeline::MAX_BATCH_SIZE;
+
+TokenPipeline::TokenPipeline(Lexer& lexer, std::size_t ringCapacity) :
+	m_lexer(lexer), m_filled(ringCapacity), m_drained(m_filled.GetCapacity() + 2),
+	m_batches(m_filled.GetCapacity() + 2),
+	m_batch(nullptr), m_batchIndex(0), m_endOfFile{ nullptr, 0, 0 }, m_isEndOfFile(false),
+	m_isStopped(false)
+{
+	// One batch more than the ring holds is being filled, and one more is being drained
+	for (Batch& batch : m_batches)
+	{
+		batch.reserve(MIN_BATCH_SIZE);
+
+		const bool isPushed = m_drained.TryPush(&batch);
+		assert(isPushed);
+		(void)isPushed;
+	}
+
+	// Builds the line index before the lexer thread starts, so line lookups never race with it
+	m_lexer.GetLine(0);
+
+	m_current = &m_endOfFile;
+	m_producer = std::thread(&TokenPipeline::Produce, this);
+}
+
+TokenPipeline::~TokenPipeline()
+{
+	m_isStopped.store(true, std::memory_order_relaxed);
+	m_producer.join();
+
+	// Tokens lexed but never consumed still belong to the pipeline
+	if (m_batch != nullptr)
+	{
+		for (std::size_t i = m_batchIndex; i < m_batch->size(); ++i)
+		{
+			delete (*m_batch)[i].token;
+		}
+	}
+
+	Batch* batch;
+	while (m_filled.TryPop(batch))
+	{
+		for (const Entry& entry : *batch)
+		{
+			delete entry.token;
+		}
+	}
+}
+
+Token* TokenPipeline::GetToken()
+{
+	if (m_batch != nullptr && m_batchIndex == m_batch->size())
+	{
+		const bool isPushed = m_drained.TryPush(m_batch);
+		assert(isPushed);
+		(void)isPushed;
+
+		m_batch = nullptr;
+	}
+
+	if (m_isEndOfFile)
+	{
+		return new Token(TokenType::END_OF_FILE);
+	}
+
+	if (m_batch == nullptr)
+	{
+		while (!m_filled.TryPop(m_batch))
+		{
+			std::this_thread::yield();
+		}
+
+		m_batchIndex = 0;
+	}
+
+	m_current = &(*m_batch)[m_batchIndex++];
+
+	if (m_current->token->token == TokenType::END_OF_FILE)
+	{
+		m_endOfFile = *m_current;
+		m_current = &m_endOfFile;
+		m_isEndOfFile = true;
+	}
+
+	return m_current->token;
+}
+
+void TokenPipeline::Produce()
+{
+	std::size_t batchSize = MIN_BATCH_SIZE;
+	bool isEndOfFile = false;
+
+	while (!isEndOfFile && !m_isStopped.load(std::memory_order_relaxed))
+	{
+		Batch* batch;
+		while (!m_drained.TryPop(batch))
+		{
+			if (m_isStopped.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			std::this_thread::yield();
+		}
+
+		batch->clear();
+
+		while (batch->size() < batchSize && !isEndOfFile)
+		{
+			Token* token = m_lexer.GetToken();
+
+			if (token->token == TokenType::UNKNOWN)
+			{
+				delete token;
+				continue;
+			}
+
+			isEndOfFile = token->token == TokenType::END_OF_FILE;
+			batch->push_back({ token, m_lexer.GetTokenOffset(), m_lexer.GetTokenLength() });
+		}
+
+		// A backed-up ring means the consumer is the bottleneck, so fewer and larger handoffs pay off;
+		// an empty ring means the consumer is waiting, so smaller batches cut its latency
+		const std::size_t pending = m_filled.GetSizeApprox();
+
+		if (pending == 0)
+		{
+			batchSize = std::max(batchSize / 2, MIN_BATCH_SIZE);
+		}
+		else if (pending >= m_filled.GetCapacity() / 2)
+		{
+			batchSize = std::min(batchSize * 2, MAX_BATCH_SIZE);
+		}
+
+		while (!m_filled.TryPush(batch))
+		{
+			if (m_isStopped.load(std::memory_order_relaxed))
+			{
+				for (const Entry& entry : *batch)
+				{
+					delete entry.token;
+				}
+
+				return;
+			}
+
+			std::this_thread::yield();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "TokenStream.h"
+#include "Utf8.h"
+
+#include <algorithm>
+
+namespace
+{
+	const std::uint8_t MAGIC[4] = { 'L', 'T', 'S', '1' };
+	const std::size_t HEADER_SIZE = 20;
+	const std::size_t CHECKPOINT_SIZE = 8;
+
+	void PutUInt32(std::uint8_t* dest, std::uint32_t value)
+	{
+		dest[0] = static_cast<std::uint8_t>(value);
+		dest[1] = static_cast<std::uint8_t>(value >> 8);
+		dest[2] = static_cast<std::uint8_t>(value >> 16);
+		dest[3] = static_cast<std::uint8_t>(value >> 24);
+	}
+
+	std::uint32_t GetUInt32(const std::uint8_t* src)
+	{
+		return static_cast<std::uint32_t>(src[0]) |
+			(static_cast<std::uint32_t>(src[1]) << 8) |
+			(static_cast<std::uint32_t>(src[2]) << 16) |
+			(static_cast<std::uint32_t>(src[3]) << 24);
+	}
+
+	void PutVarint(std::vector<std::uint8_t>& dest, std::size_t value)
+	{
+		while (value >= 0x80)
+		{
+			dest.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+
+		dest.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	bool GetVarint(const std::uint8_t*& src, const std::uint8_t* end, std::size_t& value)
+	{
+		value = 0;
+
+		for (int shift = 0; src != end && shift < 35; shift += 7)
+		{
+			const std::uint8_t byte = *src++;
+			value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool IsSymbol(const char* source, std::size_t pos, std::size_t size, Symbol symbol)
+	{
+		return pos < size && +(CHAR_TO_SYMBOL_MAP[static_cast<unsigned char>(source[pos])] & symbol);
+	}
+
+	// Re-derives the length of a well-formed token from the source text
+	std::size_t ImpliedLength(TokenType token, const char* source, std::size_t offset, std::size_t size)
+	{
+		std::size_t pos = offset + 1;
+
+		// Only identifiers and keywords start with a letter, whatever TokenType a dialect maps the keyword to
+		const char* next = MatchXidStart(source + offset, source + size);
+		if (next != nullptr || IsSymbol(source, offset, size, Symbol::LETTER))
+		{
+			pos = next != nullptr ? next - source : pos;
+
+			while (true)
+			{
+				while (IsSymbol(source, pos, size, Symbol::DIGIT | Symbol::LETTER))
+				{
+					++pos;
+				}
+
+				next = MatchXidContinue(source + pos, source + size);
+				if (next == nullptr)
+				{
+					break;
+				}
+
+				pos = next - source;
+			}
+
+			return pos - offset;
+		}
+
+		switch (token)
+		{
+		case TokenType::END_OF_FILE:
+			return 0;
+
+		case TokenType::OP_EQUAL:
+		case TokenType::OP_NOTEQUAL:
+		case TokenType::OP_LESSTHANEQUAL:
+		case TokenType::OP_GREATERTHANEQUAL:
+		case TokenType::OP_AND:
+		case TokenType::OP_OR:
+			return 2;
+
+		case TokenType::NUM_INT:
+		case TokenType::NUM_DOUBLE:
+		case TokenType::NUM:
+			while (IsSymbol(source, pos, size, Symbol::DIGIT))
+			{
+				++pos;
+			}
+
+			if (pos < size && source[pos] == '.')
+			{
+				++pos;
+
+				while (IsSymbol(source, pos, size, Symbol::DIGIT))
+				{
+					++pos;
+				}
+			}
+
+			if (pos < size && source[pos] == 'E')
+			{
+				++pos;
+
+				if (pos < size && (source[pos] == '+' || source[pos] == '-'))
+				{
+					++pos;
+				}
+
+				while (IsSymbol(source, pos, size, Symbol::DIGIT))
+				{
+					++pos;
+				}
+			}
+
+			return pos - offset;
+
+		case TokenType::CHAR:
+		case TokenType::STRING_LITERAL:
+			while (pos < size && source[pos] != source[offset])
+			{
+				++pos;
+			}
+
+			return pos - offset + 1;
+
+		default:
+			return 1;
+		}
+	}
+}
+
+char PackedToken::GetChVal() const
+{
+	assert(token == TokenType::CHAR);
+
+	const char* text = source + offset;
+
+	if (text[1] == '\\' && length == 4)
+	{
+		switch (text[2])
+		{
+		case 'n':	return 0xa;
+		case 'r':	return 0xd;
+		case 't':	return 0x9;
+		default:	return 0x0;
+		}
+	}
+
+	return text[1];
+}
+
+const char* PackedToken::GetStrVal() const
+{
+	if (token == TokenType::STRING_LITERAL)
+	{
+		return source + offset + 1;
+	}
+
+	return source + offset;
+}
+
+std::size_t PackedToken::GetStrLength() const
+{
+	if (token == TokenType::STRING_LITERAL)
+	{
+		return length - 2;
+	}
+
+	return length;
+}
+
+PackedTokenWriter::PackedTokenWriter(std::uint32_t checkpointInterval) :
+	m_data(HEADER_SIZE), m_checkpointInterval(checkpointInterval),
+	m_tokenCount(0), m_prevOffset(0)
+{
+	assert(m_checkpointInterval > 0);
+}
+
+void PackedTokenWriter::Append(TokenType token, std::size_t offset, std::size_t length)
+{
+	static_assert(static_cast<int>(TokenType::UNKNOWN) < 0x100, "TokenType must fit in one byte");
+	assert(offset >= m_prevOffset);
+
+	if (m_tokenCount % m_checkpointInterval == 0)
+	{
+		m_checkpoints.push_back({
+			static_cast<std::uint32_t>(m_data.size()),
+			static_cast<std::uint32_t>(m_prevOffset) });
+	}
+
+	m_data.push_back(static_cast<std::uint8_t>(token));
+	PutVarint(m_data, offset - m_prevOffset);
+
+	if (token == TokenType::ERROR)
+	{
+		PutVarint(m_data, length);
+	}
+
+	m_prevOffset = offset;
+	++m_tokenCount;
+}
+
+void PackedTokenWriter::Append(Lexer& lexer)
+{
+	while (true)
+	{
+		Token* token = lexer.GetToken();
+		const TokenType type = token->token;
+		delete token;
+
+		if (type == TokenType::UNKNOWN)
+		{
+			continue;
+		}
+
+		Append(type, lexer.GetTokenOffset(), lexer.GetTokenLength());
+
+		if (type == TokenType::END_OF_FILE)
+		{
+			break;
+		}
+	}
+}
+
+std::vector<std::uint8_t> PackedTokenWriter::Finish()
+{
+	const std::size_t tableOffset = m_data.size();
+
+	m_data.resize(tableOffset + m_checkpoints.size() * CHECKPOINT_SIZE);
+
+	for (std::size_t i = 0; i < m_checkpoints.size(); ++i)
+	{
+		std::uint8_t* entry = &m_data[tableOffset + i * CHECKPOINT_SIZE];
+
+		PutUInt32(entry, m_checkpoints[i].recordOffset);
+		PutUInt32(entry + 4, m_checkpoints[i].baseOffset);
+	}
+
+	std::copy(MAGIC, MAGIC + 4, m_data.begin());
+	PutUInt32(&m_data[4], m_checkpointInterval);
+	PutUInt32(&m_data[8], m_tokenCount);
+	PutUInt32(&m_data[12], static_cast<std::uint32_t>(m_checkpoints.size()));
+	PutUInt32(&m_data[16], static_cast<std::uint32_t>(tableOffset));
+
+	std::vector<std::uint8_t> result;
+	result.swap(m_data);
+
+	m_data.resize(HEADER_SIZE);
+	m_checkpoints.clear();
+	m_tokenCount = 0;
+	m_prevOffset = 0;
+
+	return result;
+}
+
+PackedTokenReader::PackedTokenReader() :
+	m_data(nullptr), m_records(nullptr), m_recordsEnd(nullptr),
+	m_checkpoints(nullptr), m_cursor(nullptr),
+	m_source(nullptr), m_sourceSize(0),
+	m_checkpointInterval(0), m_tokenCount(0), m_checkpointCount(0),
+	m_index(0), m_prevOffset(0)
+{
+
+}
+
+bool PackedTokenReader::Open(const std::uint8_t* data, std::size_t size, const char* source, std::size_t sourceSize)
+{
+	if (size < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, data))
+	{
+		return false;
+	}
+
+	const std::uint32_t interval = GetUInt32(data + 4);
+	const std::uint32_t tokenCount = GetUInt32(data + 8);
+	const std::uint32_t checkpointCount = GetUInt32(data + 12);
+	const std::uint32_t tableOffset = GetUInt32(data + 16);
+
+	if (interval == 0 || tableOffset < HEADER_SIZE || tableOffset > size ||
+		(size - tableOffset) / CHECKPOINT_SIZE < checkpointCount ||
+		checkpointCount != (tokenCount + interval - 1) / interval)
+	{
+		return false;
+	}
+
+	m_data = data;
+	m_records = data + HEADER_SIZE;
+	m_recordsEnd = data + tableOffset;
+	m_checkpoints = data + tableOffset;
+	m_source = source;
+	m_sourceSize = sourceSize;
+	m_checkpointInterval = interval;
+	m_tokenCount = tokenCount;
+	m_checkpointCount = checkpointCount;
+
+	return Seek(0);
+}
+
+bool PackedTokenReader::Seek(std::size_t index)
+{
+	if (m_data == nullptr || index > m_tokenCount)
+	{
+		return false;
+	}
+
+	const std::size_t checkpoint = index / m_checkpointInterval;
+
+	if (checkpoint == m_checkpointCount)
+	{
+		// Only reachable when seeking to the end of a stream
+		m_cursor = m_recordsEnd;
+		m_index = index;
+		return true;
+	}
+
+	const std::uint8_t* entry = m_checkpoints + checkpoint * CHECKPOINT_SIZE;
+
+	m_cursor = m_data + GetUInt32(entry);
+	m_prevOffset = GetUInt32(entry + 4);
+	m_index = checkpoint * m_checkpointInterval;
+
+	if (m_cursor < m_records || m_cursor > m_recordsEnd)
+	{
+		return false;
+	}
+
+	TokenType token;
+	std::size_t offset, length;
+
+	while (m_index < index)
+	{
+		if (!ReadRecord(token, offset, length))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool PackedTokenReader::Next(PackedToken& token)
+{
+	if (m_index >= m_tokenCount || !ReadRecord(token.token, token.offset, token.length))
+	{
+		return false;
+	}
+
+	if (token.token != TokenType::ERROR)
+	{
+		token.length = ImpliedLength(token.token, m_source, token.offset, m_sourceSize);
+	}
+
+	// A stream paired with the wrong source can imply a token running off its end,
+	// such as a string literal whose closing quote is missing
+	if (token.length > m_sourceSize - token.offset)
+	{
+		return false;
+	}
+
+	token.source = m_source;
+
+	return true;
+}
+
+bool PackedTokenReader::ReadRecord(TokenType& token, std::size_t& offset, std::size_t& length)
+{
+	std::size_t delta;
+
+	if (m_cursor == m_recordsEnd)
+	{
+		return false;
+	}
+
+	token = static_cast<TokenType>(*m_cursor++);
+
+	if (!GetVarint(m_cursor, m_recordsEnd, delta))
+	{
+		return false;
+	}
+
+	length = 0;
+	if (token == TokenType::ERROR && !GetVarint(m_cursor, m_recordsEnd, length))
+	{
+		return false;
+	}
+
+	offset = m_prevOffset + delta;
+	m_prevOffset = offset;
+	++m_index;
+
+	return offset <= m_sourceSize;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "Lexer.h"
+
+#include <cstdint>
+#include <vector>
+
+// Packed token stream layout (all integers are little-endian)
+//
+//	header		magic "LTS1", checkpoint interval, token count,
+//				checkpoint count, checkpoint table offset (5 x uint32)
+//	records		1-byte TokenType, varint delta from the previous token's offset,
+//				varint length for ERROR tokens only (other lengths are implied by the source)
+//	checkpoints	record offset and base source offset (2 x uint32) every N tokens
+struct PackedToken
+{
+	// Interface for accessing the values Lexer::GetToken() produces
+	char GetChVal() const;
+
+	// Not null-terminated, points into the source
+	const char* GetStrVal() const;
+	std::size_t GetStrLength() const;
+
+	TokenType token;
+	std::size_t offset;
+	std::size_t length;
+	const char* source;
+};
+
+class PackedTokenWriter
+{
+public:
+	static const std::uint32_t DEFAULT_CHECKPOINT_INTERVAL = 64;
+
+	explicit PackedTokenWriter(std::uint32_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL);
+
+	void Append(TokenType token, std::size_t offset, std::size_t length);
+
+	// Drains the lexer until END_OF_FILE, skipping comments
+	void Append(Lexer& lexer);
+
+	std::vector<std::uint8_t> Finish();
+
+private:
+	struct Checkpoint
+	{
+		std::uint32_t recordOffset;
+		std::uint32_t baseOffset;
+	};
+
+	std::vector<std::uint8_t> m_data;
+	std::vector<Checkpoint> m_checkpoints;
+
+	std::uint32_t m_checkpointInterval;
+	std::uint32_t m_tokenCount;
+	std::size_t m_prevOffset;
+};
+
+// Zero-copy reader over a packed stream and the source it was built from
+class PackedTokenReader
+{
+public:
+	PackedTokenReader();
+
+	bool Open(const std::uint8_t* data, std::size_t size, const char* source, std::size_t sourceSize);
+
+	std::size_t GetTokenCount() const
+	{
+		return m_tokenCount;
+	}
+
+	bool Seek(std::size_t index);
+	bool Next(PackedToken& token);
+
+private:
+	bool ReadRecord(TokenType& token, std::size_t& offset, std::size_t& length);
+
+	const std::uint8_t* m_data;
+	const std::uint8_t* m_records;
+	const std::uint8_t* m_recordsEnd;
+	const std::uint8_t* m_checkpoints;
+	const std::uint8_t* m_cursor;
+
+	const char* m_source;
+	std::size_t m_sourceSize;
+
+	std::uint32_t m_checkpointInterval;
+	std::uint32_t m_tokenCount;
+	std::uint32_t m_checkpointCount;
+
+	std::size_t m_index;
+	std::size_t m_prevOffset;
+};
+
+#endif
\ No newline at end of file
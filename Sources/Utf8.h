@@ -0,0 +1,27 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+
+const std::uint32_t INVALID_CODE_POINT = 0xffffffff;
+
+inline bool IsAscii(char ch)
+{
+	return static_cast<unsigned char>(ch) < 0x80;
+}
+
+// Returns the offset of the first ill-formed sequence, or size if the whole input is well-formed
+std::size_t ValidateUtf8(const char* data, std::size_t size);
+
+// Decodes one sequence and advances iter past it, INVALID_CODE_POINT if ill-formed
+std::uint32_t DecodeUtf8(const char*& iter, const char* end);
+
+bool IsXidStart(std::uint32_t codePoint);
+bool IsXidContinue(std::uint32_t codePoint);
+
+// Returns the end of a non-ASCII identifier character at iter, nullptr if there is none
+const char* MatchXidStart(const char* iter, const char* end);
+const char* MatchXidContinue(const char* iter, const char* end);
+
+#endif
\ No newline at end of file
@@ -1,64 +1,74 @@
 #include "Utils.h"
 
-#include <cstring>
+#include <fstream>
 
-int HashFuncAccum(const char* str)
+ReadStatus ReadFile(const char* fileName, std::string& dest, std::size_t maxSize)
 {
-	int nAccum = 0;
-	int i = 0;
+	// Binary mode keeps offsets into dest equal to byte offsets in the file
+	std::ifstream file(fileName, std::ios::in | std::ios::binary);
 
-	for (; str[i] != '\0'; ++i)
+	dest.clear();
+
+	if (!file.is_open())
 	{
-		nAccum += (str[i] - 'a');
+		return ReadStatus::UNREADABLE;
 	}
 
-	nAccum = 3 * str[0] + 1 * str[i - 1] + 2 * str[(i - 1) >> 2];
+	file.seekg(0, std::ios::end);
+	const std::streamoff size = file.tellg();
 
-	return abs(nAccum) % HashingTab::NUM_LOAD_FACTOR;
-}
+	// Pipes and /proc files report no size, those are read in chunks until EOF
+	if (size <= 0)
+	{
+		const std::size_t CHUNK_SIZE = 64 * 1024;
+		std::size_t length = 0;
 
-void HashingTab::Build(const char** strArray)
-{
-	int i = 0;
+		file.clear();
 
-	for (; strArray[i] != nullptr; ++i)
-	{
-		const int nAccum = m_hashFunc(strArray[i]);
-		const int nKey = nAccum % NUM_LOAD_FACTOR;
+		do
+		{
+			dest.resize(length + CHUNK_SIZE);
+			file.read(&dest[length], CHUNK_SIZE);
+			length += static_cast<std::size_t>(file.gcount());
+
+			if (maxSize != 0 && length > maxSize)
+			{
+				dest.clear();
+				return ReadStatus::TOO_LARGE;
+			}
+		} while (file);
+
+		dest.resize(length);
 
-		if (m_hashTab[nKey] == nullptr)
+		if (file.bad())
 		{
-			m_hashTab[nKey] = new SeparateChain;
+			dest.clear();
+			return ReadStatus::UNREADABLE;
 		}
 
-		m_hashTab[nKey]->emplace_back(std::move(strArray[i]));
+		return ReadStatus::OK;
 	}
-}
 
-const char* HashingTab::Match(const char* src)
-{
-	const int nPattern = HashFuncAccum(src);
-
-	SeparateChain* chain = m_hashTab[nPattern % NUM_LOAD_FACTOR];
-
-	if (chain == nullptr)
+	// Directories open on some platforms and report a size no string can hold
+	if (static_cast<std::size_t>(size) > dest.max_size())
 	{
-		return nullptr;
+		return ReadStatus::UNREADABLE;
 	}
 
-	ChainIter iter = chain->begin();
-	for (; iter != chain->end(); ++iter)
+	// Checked before allocating, so an oversized file never reaches memory
+	if (maxSize != 0 && static_cast<std::size_t>(size) > maxSize)
 	{
-		if (_stricmp(src, (*iter).c_str()) == 0)
-		{
-			break;
-		}
+		return ReadStatus::TOO_LARGE;
 	}
 
-	if (iter == chain->end())
+	dest.resize(static_cast<std::size_t>(size));
+	file.seekg(0, std::ios::beg);
+
+	if (!file.read(&dest[0], dest.size()))
 	{
-		return nullptr;
+		dest.clear();
+		return ReadStatus::UNREADABLE;
 	}
 
-	return (*iter).c_str();
+	return ReadStatus::OK;
 }
\ No newline at end of file
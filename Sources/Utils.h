@@ -1,40 +1,121 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <functional>
-#include <list>
+#include <atomic>
 #include <string>
 #include <vector>
 
-int HashFuncAccum(const char* str);
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
-class HashingTab
+// Index of the lowest set bit, mask must not be zero
+inline int CountTrailingZeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+enum class ReadStatus
+{
+	OK,
+	UNREADABLE,
+	TOO_LARGE
+};
+
+// Replaces dest with the file's contents, keeping its capacity. A file over maxSize bytes
+// leaves dest empty; zero means no limit. Files of unknown size, like pipes, are read until EOF.
+ReadStatus ReadFile(const char* fileName, std::string& dest, std::size_t maxSize = 0);
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread
+template <typename T>
+class SpscRing
 {
 public:
-	static const int NUM_LOAD_FACTOR = 17;
+	explicit SpscRing(std::size_t capacity) :
+		m_mask(0), m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0)
+	{
+		std::size_t size = 1;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+
+		m_buffer.resize(size);
+		m_mask = size - 1;
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
 
-	HashingTab() : m_hashTab(NUM_LOAD_FACTOR)
+	// Producer side
+	bool TryPush(T value)
 	{
-		for (OpenHashing::size_type i = 0; i < m_hashTab.size(); ++i)
+		const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail - m_cachedHead == m_buffer.size())
 		{
-			m_hashTab[i] = nullptr;
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+
+			if (tail - m_cachedHead == m_buffer.size())
+			{
+				return false;
+			}
 		}
 
-		m_hashFunc = HashFuncAccum;
+		m_buffer[tail & m_mask] = std::move(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
 	}
 
-	void Build(const char** strArray);
+	// Consumer side
+	bool TryPop(T& value)
+	{
+		const std::size_t head = m_head.load(std::memory_order_relaxed);
+
+		if (head == m_cachedTail)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+			if (head == m_cachedTail)
+			{
+				return false;
+			}
+		}
+
+		value = std::move(m_buffer[head & m_mask]);
+		m_head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
 
-	const char* Match(const char* src);
+	// Exact only when both sides are idle
+	std::size_t GetSizeApprox() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+
+	std::size_t GetCapacity() const
+	{
+		return m_buffer.size();
+	}
 
 private:
-	using SeparateChain = std::list<std::string>;
-	using ChainIter = SeparateChain::iterator;
-	using OpenHashing = std::vector<SeparateChain*>;
-	using HashFunc = std::function<int(const char*)>;
+	std::vector<T> m_buffer;
+	std::size_t m_mask;
+
+	// Head and tail live on separate cache lines, each next to the copy its owner caches
+	alignas(64) std::atomic<std::size_t> m_head;
+	std::size_t m_cachedTail;
 
-	OpenHashing m_hashTab;
-	HashFunc m_hashFunc;
+	alignas(64) std::atomic<std::size_t> m_tail;
+	std::size_t m_cachedHead;
 };
 
 #endif
\ No newline at end of file